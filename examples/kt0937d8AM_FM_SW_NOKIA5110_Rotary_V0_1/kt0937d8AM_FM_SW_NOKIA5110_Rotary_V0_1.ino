@@ -13,6 +13,7 @@
 #include <Wire.h>
 #include <U8x8lib.h>
 #include <AiEsp32RotaryEncoder.h>
+#include <EEPROM.h>
 
 
 //GPIO 13 as PIN_INPUT_FUN , and the sleep wake up PIN.
@@ -91,6 +92,10 @@ AiEsp32RotaryEncoder rotaryEncoder = AiEsp32RotaryEncoder(PIN_ROTARY_A, PIN_ROTA
 #define OLED_REFLASH_ELAPSED_TIME 6000  // time to flash milliseconds 3000 ms = 3 second
 #define WAKE_UP_ELAPSED_TIME 12000
 
+//station memory: band and volume are saved once the rotary has been idle for STATION_SAVE_DELAY
+#define STATION_EEPROM_SIZE 256
+#define STATION_SAVE_DELAY 5000
+
 typedef struct{
   uint16_t lowFreq;  //Low Frequency /1kHz , as 12MHz 12000kHz / 1kHz = 12000
   uint16_t highFreq; //High Frequency /1kHz, as 13 MHz 13000kHz /1kHz = 13000
@@ -111,6 +116,33 @@ U8X8_PCD8544_84X48_4W_SW_SPI u8x8(/* clock=*/ 14, /* data=*/ 27, /* cs=*/ 25, /*
 
 KT0937 radio;
 
+//ESP32 EEPROM (flash emulated) as KT0937Storage
+class EEPROMStorage : public KT0937Storage
+{
+public:
+  uint16_t size() { return STATION_EEPROM_SIZE; }
+  bool read(uint16_t address, uint8_t *buf, uint16_t n)
+  {
+    for (uint16_t i = 0; i < n; i++) buf[i] = EEPROM.read(address + i);
+    return true;
+  }
+  bool write(uint16_t address, const uint8_t *buf, uint16_t n)
+  {
+    for (uint16_t i = 0; i < n; i++) EEPROM.write(address + i, buf[i]);
+    return EEPROM.commit();
+  }
+  bool erase(uint16_t address, uint16_t n)
+  {
+    for (uint16_t i = 0; i < n; i++) EEPROM.write(address + i, 0xFF);
+    return EEPROM.commit();
+  }
+};
+
+EEPROMStorage eepromStorage;
+KT0937StationStore stationStore(eepromStorage);
+bool stationDirty = false;
+long stationChangedTime = 0;
+
 
 
 
@@ -123,7 +155,6 @@ long frame_duration_start_time = 0;
 int8_t band = BAND_FM ;
 
 bool isBandChanged = 0;
-bool intISRflag = false;
 
 long oled_showed_time = 0;
 bool oled_show_flag = true;
@@ -133,6 +164,11 @@ long wake_up_time = 0;
 uint8_t currentMode = VOL_MODE;
 int8_t currentVol = 15;  
 
+//signal shown on the display, refreshed by the telemetry callback only when it changes
+uint8_t signalRSSI = 0;
+uint8_t signalSNR = 0;
+bool signalDirty = false;
+
 sw_band_record_t swBandTable[31] = 
 {
 //{ low,high,channum } , 
@@ -170,6 +206,19 @@ sw_band_record_t swBandTable[31] =
 
 };
 
+//band register images, computed once in setup() so a band switch only sends the registers that change
+kt09xx_band_image fmBandImage;
+kt09xx_band_image mwBandImage;
+kt09xx_band_image swBandImage[31];
+
+void prepareBandImages()
+{
+  radio.getBandImage(KT0937_FM_BAND, fmBandImage);
+  radio.getBandImage(KT0937_MW_BAND, mwBandImage);
+  for (uint8_t i = 0; i < 31; i++)
+    radio.getBandImage(makeSWBand(swBandTable[i].lowFreq, swBandTable[i].highFreq, swBandTable[i].chanNum), swBandImage[i]);
+}
+
 void doRotarySWFun()
 {
   //reflash oled
@@ -202,6 +251,9 @@ void rotary_onChanged()
   //renew the wake up time.
   wake_up_time = millis();
 
+  stationDirty = true;
+  stationChangedTime = millis();
+
   if(currentMode == VOL_MODE)
   {
     currentVol = rotaryEncoder.readEncoder();
@@ -257,18 +309,40 @@ void doBandDown()
   isBandChanged = 1;
 }
 
+const kt09xx_band_image &getBandImageOf(int8_t b)
+{
+  if (b == BAND_FM) return fmBandImage;
+  if (b == BAND_AM) return mwBandImage;
+  return swBandImage[b - 2];
+}
+
+//save band and volume once the user stopped turning the rotary
+void checkStationSave()
+{
+  if (stationDirty && (millis() - stationChangedTime) > STATION_SAVE_DELAY)
+  {
+    kt09xx_station_entry entry;
+    radio.getStationEntry(band, entry);
+    stationStore.saveStation(entry);
+    stationDirty = false;
+  }
+}
+
 void checkBand()
 {
+  //band switches are queued and run by radio.poll() in loop(), so the buttons and the display stay responsive.
+  //if the queue is full, queueBand returns false and the switch is retried at the next call
   if(isBandChanged == 1)
   {  
+    bool queued;
     switch (band) {
       case BAND_FM :
         radio.enableSWAmp(0);
-        radio.setFMBand();
+        queued = radio.queueBand(fmBandImage);
         break;
       case BAND_AM :
         radio.enableSWAmp(0);
-        radio.setAMBand();
+        queued = radio.queueBand(mwBandImage);
         //Serial.println("AM Band");
         //dumpAll();
         break;
@@ -277,11 +351,12 @@ void checkBand()
         Serial.println(band);
         
         radio.enableSWAmp(1);
-        radio.setSWBand(swBandTable[band - 2].lowFreq, swBandTable[band - 2].highFreq, swBandTable[band - 2].chanNum);
+        queued = radio.queueBand(swBandImage[band - 2]);
         //dumpAll();
         break;
     }
-    isBandChanged = 0;
+    if(queued)
+      isBandChanged = 0;
   }
 }
 
@@ -347,25 +422,31 @@ void displayBuffer()
   if(band == BAND_FM)
   {
     sprintf(display_buffer,"%s","             "); 
-    sprintf(display_buffer,"%6.2f M",float(float(radio.getCurrentFrequency())/20.0)); 
+    uint32_t khz = radio.getCurrentFrequencyKHz();
+    sprintf(display_buffer,"%3lu.%02lu M",khz / 1000, (khz % 1000) / 10); 
   }
   else if(band == BAND_AM)
   {
     sprintf(display_buffer,"%s","             "); 
-    sprintf(display_buffer,"%4d k  ",radio.getCurrentFrequency());
+    sprintf(display_buffer,"%4lu k  ",radio.getCurrentFrequencyKHz());
   }
   else 
   {
     sprintf(display_buffer,"%s","             "); 
-    sprintf(display_buffer,"%0.3fM",float(float(radio.getCurrentFrequency())/1000.0));
+    uint32_t khz = radio.getCurrentFrequencyKHz();
+    sprintf(display_buffer,"%lu.%03luM",khz / 1000, khz % 1000);
   }
   u8x8.drawString(0,2, display_buffer);
 
- //display RSSI and SNR
+  displaySignal();
+}
+
+//drawing RSSI and SNR, as last reported by the telemetry (no bus access)
+void displaySignal()
+{
   sprintf(display_buffer,"%s","             "); 
-  sprintf(display_buffer,"s:%03dr:%03d",radio.getRSSI(),radio.getSNR()); 
+  sprintf(display_buffer,"s:%03dr:%03d",signalRSSI,signalSNR); 
   u8x8.drawString(0,4, display_buffer);
-
 }
 
 //Ratary Encoder Interrupt Service Routine.
@@ -375,20 +456,15 @@ void IRAM_ATTR readEncoderISR()
 }
 
 
-//kt0937 int pin connected with rising edge interrpt service rountine. reflash the oled. 
+//kt0937 int pin interrupt service rountine. Only records the event, radio.serviceTuneEvents() in loop() handles it.
 void IRAM_ATTR tuneISR()
 {
-  //set the intISRflag to true.
-  intISRflag = true;
+  radio.onTuneInterrupt();
 }
 
-//do checking the INT ISR 
-void checkIntISR()
+//called by radio.serviceTuneEvents() once the dial has settled on a new channel. reflash the oled. 
+void channelChanged(uint32_t frequency, uint8_t rssi, uint8_t snr)
 {
-  //Serial.println("INT cheack...");
-  if( intISRflag == true)
-  {
-
   Serial.println("INT ...");
     //reflash oled
   oled_show_flag = true;
@@ -396,17 +472,30 @@ void checkIntISR()
   //renew the wake up time
   wake_up_time = millis(); 
 
-  //reset the intISRflag to false;
-  intISRflag = false;
+  signalRSSI = rssi;
+  signalSNR = snr;
+
   radio.enableINT();
-  }
+}
+
+//called by radio.pollTelemetry() when RSSI, SNR, stereo or the channel has changed.
+//the median of the last samples is shown, so a single spike does not make the meter flicker.
+void telemetryChanged(const kt09xx_signal_status &status, uint8_t changed)
+{
+  uint8_t mode = (band == BAND_FM) ? MODE_FM : MODE_AM;
+  kt09xx_signal_stats rssi, snr;
+  radio.getSignalStats(mode, SIGNAL_RSSI, rssi);
+  radio.getSignalStats(mode, SIGNAL_SNR, snr);
+  signalRSSI = rssi.median;   //dBuVEMF, as getRSSI()
+  signalSNR = snr.median;
+  signalDirty = true;
 }
 
 void setup() {
   Serial.begin(9600);
   while(!Serial);
-  Wire.begin();
-  //Wire.setClock(400000);
+  //the library initialises the bus once, at the first register access. E.g. Fast-mode:
+  //radio.setI2CBus(Wire, I2C_CLOCK_400KHZ);
   pinMode(LED_BUILTIN,OUTPUT);
 
   //lcd 5110 led pin
@@ -442,23 +531,35 @@ void setup() {
   radio.disableSWSoftMute(1);
   radio.disableSWAFC(1); 
 
+  prepareBandImages();
+
   //set INT mode
   radio.setIntMode(INT_MODE_FALLING);
 
   
-  radio.setFMBand();
-  Serial.println("FMBand setted ...");
-
-
-  
-  //Volume set 0 - 31 .
-  radio.setVolume(15);
-
-  Serial.println("Volume setted......");
+  //restore the last band and volume in one batch, FM and volume 15 the first time
+  EEPROM.begin(STATION_EEPROM_SIZE);
+  stationStore.begin();
+  kt09xx_station_entry entry;
+  if (!stationStore.loadStation(entry) || entry.band > BAND_SW31)
+  {
+    entry.band = BAND_FM;
+    entry.volume = 15;
+    entry.flags = 0;
+  }
+  band = entry.band;
+  currentVol = entry.volume;
+  radio.enableSWAmp(band >= BAND_SW1);
+  radio.applyStation(getBandImageOf(band), entry);
+  Serial.println("Band and Volume restored ...");
 
   //enable INT signal OUT 
+  radio.onChannelChanged(channelChanged);
   radio.enableINT();
 
+  //signal meter: sampled every 100ms after a tune, backing off to every 2s while the signal is stable
+  radio.onTelemetry(telemetryChanged);
+
  // dumpAll();
 
   
@@ -531,15 +632,8 @@ void setup() {
 
 void loop() {
   /*
-  //frequency
-  if(band == BAND_FM)
-  {
-    Serial.println(radio.getCurrentFrequency()*50);
-  }
-  else
-  {
-    Serial.println(radio.getCurrentFrequency());
-  }
+  //frequency (kHz)
+  Serial.println(radio.getCurrentFrequencyKHz());
 
 //band
   Serial.print("band:");
@@ -550,8 +644,16 @@ void loop() {
 
   rotary_loop();  
 
+  radio.poll();
   checkBand();
-  checkIntISR();
+  checkStationSave();
+  radio.serviceTuneEvents();
+  radio.pollTelemetry();
+  if(signalDirty && wake_up_flag)
+  {
+    displaySignal();
+    signalDirty = false;
+  }
   if((oled_show_flag == true )&&((millis()-oled_showed_time)> OLED_REFLASH_ELAPSED_TIME))
   {
     digitalWrite(LCD_5110_LED_PIN, LOW);
@@ -144,6 +144,19 @@ sw_band_record_t swBandTable[31] =
 
 };
 
+//band register images, computed once in setup() so a band switch only sends the registers that change
+kt09xx_band_image fmBandImage;
+kt09xx_band_image mwBandImage;
+kt09xx_band_image swBandImage[31];
+
+void prepareBandImages()
+{
+  radio.getBandImage(KT0937_FM_BAND, fmBandImage);
+  radio.getBandImage(KT0937_MW_BAND, mwBandImage);
+  for (uint8_t i = 0; i < 31; i++)
+    radio.getBandImage(makeSWBand(swBandTable[i].lowFreq, swBandTable[i].highFreq, swBandTable[i].chanNum), swBandImage[i]);
+}
+
 
 
 
@@ -194,16 +207,19 @@ void doubleClickBandDown()
 
 void checkBand()
 {
+  //band switches are queued and run by radio.poll() in loop(), so the buttons and the display stay responsive.
+  //if the queue is full, queueBand returns false and the switch is retried at the next call
   if(isBandChanged == 1)
   {  
+    bool queued;
     switch (band) {
       case BAND_FM :
         radio.enableSWAmp(0);
-        radio.setFMBand();
+        queued = radio.queueBand(fmBandImage);
         break;
       case BAND_AM :
         radio.enableSWAmp(0);
-        radio.setAMBand();
+        queued = radio.queueBand(mwBandImage);
         //Serial.println("AM Band");
         //dumpAll();
         break;
@@ -212,11 +228,12 @@ void checkBand()
         //Serial.println(band);
         
         radio.enableSWAmp(1);
-        radio.setSWBand(swBandTable[band - 2].lowFreq, swBandTable[band - 2].highFreq, swBandTable[band - 2].chanNum);
+        queued = radio.queueBand(swBandImage[band - 2]);
         //dumpAll();
         break;
     }
-    isBandChanged = 0;
+    if(queued)
+      isBandChanged = 0;
   }
 }
 
@@ -229,8 +246,8 @@ void checkBand()
 void setup() {
   Serial.begin(9600);
   while(!Serial);
-  Wire.begin();
-  //Wire.setClock(400000);
+  //the library initialises the bus once, at the first register access. E.g. Fast-mode:
+  //radio.setI2CBus(Wire, I2C_CLOCK_400KHZ);
   pinMode(LED_BUILTIN,OUTPUT);
   Serial.print("check chip id:");
   while(radio.getDeviceId()!= KT0937_DEV_ID){
@@ -259,8 +276,10 @@ void setup() {
   radio.disableSWSoftMute(1);
   radio.disableSWAFC(1); 
 
+  prepareBandImages();
+
   
-  radio.setFMBand();
+  radio.setBand(fmBandImage);
   Serial.println("FMBand setted ...");
 
 
@@ -338,32 +357,27 @@ void displayBuffer()
   if(band == BAND_FM)
   {
     sprintf(display_buffer,"%s","        "); 
-    sprintf(display_buffer,"%5.2f M",float(float(radio.getCurrentFrequency())/20.0)); 
+    uint32_t khz = radio.getCurrentFrequencyKHz();
+    sprintf(display_buffer,"%2lu.%02lu M",khz / 1000, (khz % 1000) / 10); 
   }
   else if(band == BAND_AM)
   {
     sprintf(display_buffer,"%s","        "); 
-    sprintf(display_buffer,"%4d k  ",radio.getCurrentFrequency());
+    sprintf(display_buffer,"%4lu k  ",radio.getCurrentFrequencyKHz());
   }
   else 
   {
     sprintf(display_buffer,"%s","        "); 
-    sprintf(display_buffer,"%0.3fM",float(float(radio.getCurrentFrequency())/1000.0));
+    uint32_t khz = radio.getCurrentFrequencyKHz();
+    sprintf(display_buffer,"%lu.%03luM",khz / 1000, khz % 1000);
   }
   u8x8.drawString(0,10, display_buffer);  
 }
 
 void loop() {
   /*
-  //frequency
-  if(band == BAND_FM)
-  {
-    Serial.println(radio.getCurrentFrequency()*50);
-  }
-  else
-  {
-    Serial.println(radio.getCurrentFrequency());
-  }
+  //frequency (kHz)
+  Serial.println(radio.getCurrentFrequencyKHz());
 
 //band
   Serial.print("band:");
@@ -376,6 +390,7 @@ void loop() {
   buttonFun.tick();
   buttonUp.tick();
   buttonDown.tick();
+  radio.poll();
   checkBand();
   if((oled_show_flag == true )&&((millis()-oled_showed_time)> OLED_REFLASH_ELAPSED_TIME))
   {
@@ -0,0 +1,77 @@
+/**
+ * @file Arduino.h
+ * @brief Host build stand-in for the Arduino core (Linux / CI). See README.md
+ * @details Only what the KT0937 library uses. Time functions run on the virtual clock of the
+ * @details simulated KT0937 (KT0937Sim), so delays cost no real time and are accounted for in the benchmarks.
+ */
+
+#ifndef _KT0937_HOST_ARDUINO_H
+#define _KT0937_HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH    1
+#define LOW     0
+#define INPUT   0
+#define OUTPUT  1
+
+#define DEC     10
+#define HEX     16
+
+/**
+ * @brief Subset of the Arduino Print class. Derived classes implement write(uint8_t).
+ */
+class Print
+{
+private:
+    size_t printNumber(unsigned long n, uint8_t base);
+
+public:
+    virtual size_t write(uint8_t c) = 0;
+    size_t write(const char *str);
+
+    size_t print(const char *str) { return write(str); }
+    size_t print(char c) { return write((uint8_t) c); }
+    size_t print(unsigned char n, int base = DEC) { return print((unsigned long) n, base); }
+    size_t print(int n, int base = DEC) { return print((long) n, base); }
+    size_t print(unsigned int n, int base = DEC) { return print((unsigned long) n, base); }
+    size_t print(long n, int base = DEC);
+    size_t print(unsigned long n, int base = DEC) { return printNumber(n, base); }
+
+    size_t println() { return write("\r\n"); }
+    template <typename T> size_t println(T value) { size_t n = print(value); return n + println(); }
+    template <typename T> size_t println(T value, int base) { size_t n = print(value, base); return n + println(); }
+};
+
+/**
+ * @brief Serial stand-in. Prints to stdout.
+ */
+class HostSerial : public Print
+{
+public:
+    void begin(unsigned long) {}
+    size_t write(uint8_t c);
+    using Print::write;
+    operator bool() { return true; }
+};
+
+extern HostSerial Serial;
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+unsigned long millis();
+unsigned long micros();
+
+#endif // _KT0937_HOST_ARDUINO_H
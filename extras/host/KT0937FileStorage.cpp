@@ -0,0 +1,69 @@
+/**
+ * @file KT0937FileStorage.cpp
+ * @brief File backed KT0937Storage, for host builds (Linux / CI). See README.md
+ */
+
+#include "KT0937FileStorage.h"
+
+/**
+ * @param path  storage file. Created (erased) if it does not exist
+ * @param size  storage size in bytes
+ */
+KT0937FileStorage::KT0937FileStorage(const char *path, uint16_t size)
+{
+    this->bytes = size;
+    this->file = fopen(path, "r+b");
+    if (this->file == NULL)
+    {
+        this->file = fopen(path, "w+b");
+        if (this->file != NULL)
+            erase(0, size);
+    }
+}
+
+KT0937FileStorage::~KT0937FileStorage()
+{
+    if (this->file != NULL)
+        fclose(this->file);
+}
+
+uint16_t KT0937FileStorage::size()
+{
+    return (this->file != NULL) ? this->bytes : 0;
+}
+
+bool KT0937FileStorage::read(uint16_t address, uint8_t *buf, uint16_t n)
+{
+    if (this->file == NULL || (uint32_t) address + n > this->bytes)
+        return false;
+    if (fseek(this->file, address, SEEK_SET) != 0)
+        return false;
+    return fread(buf, 1, n, this->file) == n;
+}
+
+bool KT0937FileStorage::write(uint16_t address, const uint8_t *buf, uint16_t n)
+{
+    if (this->file == NULL || (uint32_t) address + n > this->bytes)
+        return false;
+    if (fseek(this->file, address, SEEK_SET) != 0)
+        return false;
+    if (fwrite(buf, 1, n, this->file) != n)
+        return false;
+    return fflush(this->file) == 0;
+}
+
+bool KT0937FileStorage::erase(uint16_t address, uint16_t n)
+{
+    uint8_t erased[64];
+    memset(erased, 0xFF, sizeof(erased));
+
+    while (n)
+    {
+        uint16_t chunk = (n > sizeof(erased)) ? sizeof(erased) : n;
+        if (!write(address, erased, chunk))
+            return false;
+        address += chunk;
+        n -= chunk;
+    }
+    return true;
+}
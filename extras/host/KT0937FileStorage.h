@@ -0,0 +1,30 @@
+/**
+ * @file KT0937FileStorage.h
+ * @brief File backed KT0937Storage, for host builds (Linux / CI). See README.md
+ * @details The file is created filled with 0xFF (erased) when it does not exist. Every write goes to the file
+ * @details at once, so the content survives the process like an EEPROM survives a reset.
+ */
+
+#ifndef _KT0937_FILE_STORAGE_H
+#define _KT0937_FILE_STORAGE_H
+
+#include <stdio.h>
+#include <KT0937.h>
+
+class KT0937FileStorage : public KT0937Storage
+{
+private:
+    FILE *file = NULL;
+    uint16_t bytes;
+
+public:
+    KT0937FileStorage(const char *path, uint16_t size);
+    ~KT0937FileStorage();
+
+    uint16_t size();
+    bool read(uint16_t address, uint8_t *buf, uint16_t n);
+    bool write(uint16_t address, const uint8_t *buf, uint16_t n);
+    bool erase(uint16_t address, uint16_t n);
+};
+
+#endif // _KT0937_FILE_STORAGE_H
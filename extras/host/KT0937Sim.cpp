@@ -0,0 +1,552 @@
+/**
+ * @file KT0937Sim.cpp
+ * @brief Register level model of the KT0937-D8 and the Arduino core / Wire stand-ins for host builds. See README.md
+ */
+
+#include <stdio.h>
+#include "KT0937Sim.h"
+
+KT0937Sim kt0937Sim;
+TwoWire Wire;
+HostSerial Serial;
+
+/**
+ * @brief Power-on defaults, from the "Default Value" docs of the kt09xx_* unions in KT0937.h.
+ * @details Registers not listed read 0x00.
+ */
+static const uint8_t registerDefaults[][2] = {
+    {0x00, SIM_DEVICE_ID},     // deviceid_0
+    {0x04, 0x00},     // pllcfg_0
+    {0x05, 0x01},     // pllcfg_1
+    {0x06, 0x02},     // pllcfg_2
+    {0x07, 0x9C},     // pllcfg_3
+    {0x08, 0x08},     // sysclk_cfg_0
+    {0x09, 0x00},     // sysclk_cfg_1
+    {0x0A, 0x00},     // sysclk_cfg_2
+    {0x0D, 0xC3},     // xtalcfg
+    {0x0E, 0x00},     // rxcfg_0
+    {0x0F, 0x1F},     // rxcfg_1
+    {0x10, 0x00},     // pvtcali_0
+    {0x16, 0x8A},     // bandcfg_0
+    {0x18, 0x59},     // bandcfg_2
+    {0x19, 0x31},     // bandcfg_3
+    {0x1A, 0x08},     // mutecfg_0
+    {0x1B, 0x80},     // g38kcfg_0
+    {0x1C, 0x00},     // g38kcfg_1
+    {0x1D, 0x97},     // softmute_0
+    {0x1E, 0x24},     // softmute_1
+    {0x1F, 0x53},     // softmute_2
+    {0x20, 0x30},     // softmute_3
+    {0x21, 0x02},     // softmute_4
+    {0x22, 0x15},     // softmute_5
+    {0x28, 0x0D},     // soundcfg
+    {0x29, 0x00},     // fltcfg
+    {0x2A, 0xC0},     // dspcfg_0
+    {0x2B, 0xA8},     // dspcfg_1
+    {0x2C, 0x5F},     // dspcfg_2
+    {0x2F, 0x00},     // dspcfg_5
+    {0x30, 0x00},     // dspcfg_6
+    {0x34, 0x00},     // dspcfg_7
+    {0x35, 0x00},     // dspcfg_8
+    {0x38, 0x54},     // swcfg_0
+    {0x39, 0x0A},     // swcfg_1
+    {0x3A, 0x1B},     // swcfg_2
+    {0x3E, 0x03},     // afc_2
+    {0x3F, 0x00},     // afc_3
+    {0x4E, 0x32},     // anacfg_0
+    {0x4F, 0x82},     // anacfg_1
+    {0x51, 0x00},     // gpiocfg_2
+    {0x52, 0x16},     // swcfg_3
+    {0x55, 0x04},     // amcali_0
+    {0x56, 0x3F},     // amcali_1
+    {0x57, 0xEF},     // amcali_2
+    {0x62, 0x41},     // amdsp_0
+    {0x63, 0x00},     // amdsp_1
+    {0x65, 0xD0},     // amdsp_3
+    {0x66, 0x18},     // amdsp_4
+    {0x67, 0x1B},     // amdsp5
+    {0x68, 0x00},     // amdsp_6
+    {0x69, 0x8A},     // amdsp_7
+    {0x71, 0x00},     // adc_0
+    {0x74, 0xE1},     // adc_3
+    {0x75, 0x14},     // adc_4
+    {0x76, 0xA6},     // adc_5
+    {0x7E, 0x2C},     // fmst_cfg
+    {0x7F, 0x55},     // fmtune_valid_0
+    {0x80, 0x55},     // fmtune_valid_1
+    {0x81, 0x3A},     // mwtune_valid_0
+    {0x82, 0x35},     // mwtune_valid_1
+    {0x83, 0x24},     // mwtune_valid_2
+    {0x84, 0x24},     // mwtune_valid_3
+    {0x87, 0x00},     // spare_2
+    {0x88, 0x46},     // fm_chan_0
+    {0x89, 0xB8},     // fm_chan_1
+    {0x8C, 0x01},     // am_chan_0
+    {0x8D, 0xF8},     // am_chan_1
+    {0x98, 0x01},     // low_chan_0
+    {0x99, 0x00},     // low_chan_1
+    {0x9A, 0x00},     // chan_num_0
+    {0x9B, 0x00},     // chan_num_1
+    {0xA0, 0x17},     // guard_2
+    {0xDE, 0xD2},     // status_0
+    {0xE2, 0x00},     // status_4
+    {0xE3, 0x00},     // status_5
+    {0xE4, 0x06},     // status_6
+    {0xE5, 0xB8},     // status_7
+    {0xE6, 0x00},     // status_8
+    {0xE8, 0x00},     // afc_status_0
+    {0xE9, 0x00},     // afc_status_1
+    {0xEA, 0x00},     // am_status_0
+    {0xEC, 0x00},     // am_status_2
+    {0xED, 0x00},     // am_status_3
+    {0xF0, 0x3A},     // sw_tune_valid_0
+    {0xF1, 0x35},     // sw_tune_valid_1
+    {0xF2, 0x3A},     // sw_tune_valid_2
+    {0xF3, 0x1F}      // swtune_valid_3
+};
+
+KT0937Sim::KT0937Sim()
+{
+    powerOn();
+    resetCounters();
+}
+
+/**
+ * @brief Loads the power-on defaults. Pending events are dropped; the virtual clock keeps running.
+ */
+void KT0937Sim::powerOn()
+{
+    memset(this->reg, 0, sizeof(this->reg));
+    for (size_t i = 0; i < sizeof(registerDefaults) / sizeof(registerDefaults[0]); i++)
+        this->reg[registerDefaults[i][0]] = registerDefaults[i][1];
+
+    this->pointer = 0;
+    this->powerOnAt = 0;
+    this->changeBandAt = 0;
+}
+
+void KT0937Sim::resetCounters()
+{
+    memset(&this->counters, 0, sizeof(this->counters));
+}
+
+uint32_t KT0937Sim::now()
+{
+    return this->nowUs;
+}
+
+/**
+ * @brief Moves the virtual clock forward (bus or CPU time). Device events due by then take effect.
+ */
+void KT0937Sim::advance(uint32_t us)
+{
+    this->nowUs += us;
+    update();
+}
+
+/**
+ * @brief Moves the virtual clock forward on behalf of delay() / delayMicroseconds()
+ */
+void KT0937Sim::wait(uint32_t us)
+{
+    this->counters.waitUs += us;
+    advance(us);
+}
+
+/**
+ * @brief Accounts for the time of a number of bits on the bus at a given SCL clock
+ */
+void KT0937Sim::busTime(uint32_t clock, uint16_t bits)
+{
+    uint32_t us = ((uint32_t) bits * 1000000UL + clock - 1) / clock;
+    this->counters.busUs += us;
+    advance(us);
+}
+
+/**
+ * @brief Device events: POWERON_FINISH after SYS_CFGOK, CHANGE_BAND cleared after a band change
+ */
+void KT0937Sim::update()
+{
+    if (this->powerOnAt && (int32_t) (this->nowUs - this->powerOnAt) >= 0)
+    {
+        kt09xx_g38kcfg_0 g38k;
+        g38k.raw = this->reg[REG_G38KCFG0];
+        g38k.refined.POWERON_FINISH = 1;
+        this->reg[REG_G38KCFG0] = g38k.raw;
+        this->powerOnAt = 0;
+    }
+
+    if (this->changeBandAt && (int32_t) (this->nowUs - this->changeBandAt) >= 0)
+    {
+        kt09xx_fm_chan_0 fmchan0;
+        fmchan0.raw = this->reg[REG_FMCHAN0];
+        fmchan0.refined.CHANGE_BAND = 0;
+        this->reg[REG_FMCHAN0] = fmchan0.raw;
+        this->changeBandAt = 0;
+
+        //the receiver starts at the low edge of the new band
+        kt09xx_low_chan_0 low0;
+        kt09xx_low_chan_1 low1;
+        low0.raw = this->reg[REG_LOW_CHAN0];
+        low1.raw = this->reg[REG_LOW_CHAN1];
+        uint16_t channel = ((uint16_t) low0.refined.LOW_CHAN_14_8 << 8) | low1.refined.LOW_CHAN_7_0;
+        setChannel(channel);
+
+        //station table: the signal follows the channel
+        if (this->stationCount)
+        {
+            uint8_t i = 0;
+            while (i < this->stationCount && this->stations[i].channel != channel)
+                i++;
+            if (i < this->stationCount)
+                setSignal(this->stations[i].rssi, this->stations[i].snr, this->stations[i].rssi, this->stations[i].snr, true, false);
+            else
+                setSignal(SIM_NOISE_RSSI, 0, SIM_NOISE_RSSI, 0, false, false);
+        }
+    }
+}
+
+/**
+ * @brief DEVICEID / KTMARK and the status block (STATUS0 ~ AMSTATUS3) are read only
+ */
+bool KT0937Sim::isReadOnly(uint8_t r)
+{
+    return r <= REG_KTMARK1 || (r >= REG_STATUS0 && r <= REG_AMSTATUS3);
+}
+
+/**
+ * @brief Register write as seen by the device
+ */
+void KT0937Sim::writeRegister(uint8_t r, uint8_t value)
+{
+    if (isReadOnly(r))
+        return;
+
+    uint8_t previous = this->reg[r];
+
+    switch (r)
+    {
+    case REG_PLLCFG0:
+    {
+        kt09xx_pllcfg_0 before, after;
+        before.raw = previous;
+        after.raw = value;
+        if (!before.refined.SYS_CFGOK && after.refined.SYS_CFGOK)
+        {
+            kt09xx_xtalcfg xtal;
+            xtal.raw = this->reg[REG_XTALCFG];
+            this->powerOnAt = this->nowUs + (xtal.refined.RCLK_EN ? SIM_RCLK_LOCK_US : SIM_XTAL_LOCK_US);
+            if (!this->powerOnAt)
+                this->powerOnAt = 1;
+        }
+        else if (before.refined.SYS_CFGOK && !after.refined.SYS_CFGOK)
+        {
+            //the clock is being reconfigured
+            kt09xx_g38kcfg_0 g38k;
+            g38k.raw = this->reg[REG_G38KCFG0];
+            g38k.refined.POWERON_FINISH = 0;
+            this->reg[REG_G38KCFG0] = g38k.raw;
+            this->powerOnAt = 0;
+        }
+        break;
+    }
+    case REG_G38KCFG0:
+    {
+        //POWERON_FINISH is set by the device only
+        kt09xx_g38kcfg_0 before, after;
+        before.raw = previous;
+        after.raw = value;
+        after.refined.POWERON_FINISH = before.refined.POWERON_FINISH;
+        value = after.raw;
+        break;
+    }
+    case REG_FMCHAN0:
+    {
+        kt09xx_fm_chan_0 after;
+        after.raw = value;
+        if (after.refined.CHANGE_BAND)
+        {
+            this->changeBandAt = this->nowUs + SIM_CHANGE_BAND_US;
+            if (!this->changeBandAt)
+                this->changeBandAt = 1;
+        }
+        break;
+    }
+    case REG_ADC0:
+    {
+        //CH_ADC_START is a trigger bit
+        kt09xx_adc_0 after;
+        after.raw = value;
+        after.refined.CH_ADC_START = 0;
+        value = after.raw;
+        break;
+    }
+    }
+
+    this->reg[r] = value;
+}
+
+void KT0937Sim::setPointer(uint8_t r)
+{
+    this->pointer = r;
+}
+
+/**
+ * @brief Bus write of one byte at the register pointer (auto-increment)
+ */
+void KT0937Sim::write(uint8_t value)
+{
+    this->counters.registerWrites[this->pointer]++;
+    writeRegister(this->pointer++, value);
+}
+
+/**
+ * @brief Bus read of one byte at the register pointer (auto-increment)
+ */
+uint8_t KT0937Sim::read()
+{
+    return this->reg[this->pointer++];
+}
+
+uint8_t KT0937Sim::peek(uint8_t r)
+{
+    return this->reg[r];
+}
+
+void KT0937Sim::poke(uint8_t r, uint8_t value)
+{
+    this->reg[r] = value;
+}
+
+/**
+ * @brief Sets the channel reported by RDCHAN (STATUS6 / STATUS7)
+ */
+void KT0937Sim::setChannel(uint16_t channel)
+{
+    kt09xx_status_6 st6;
+    kt09xx_status_7 st7;
+    st6.raw = this->reg[REG_STATUS6];
+    st7.raw = this->reg[REG_STATUS7];
+    st6.refined.RDCHAN_14_8 = (channel >> 8) & 0x7F;
+    st7.refined.RDCHAN_7_0 = channel & 0xFF;
+    this->reg[REG_STATUS6] = st6.raw;
+    this->reg[REG_STATUS7] = st7.raw;
+}
+
+/**
+ * @brief Sets the signal reported by the status block
+ */
+void KT0937Sim::setSignal(uint8_t fmRSSI, uint8_t fmSNR, uint8_t amRSSI, uint8_t amSNR, bool valid, bool stereo)
+{
+    kt09xx_status_0 st0;
+    st0.raw = this->reg[REG_STATUS0];
+    st0.refined.VALID_TUNE = valid;
+    st0.refined.ST_TUNE = stereo;
+    this->reg[REG_STATUS0] = st0.raw;
+
+    kt09xx_status_4 st4;
+    st4.raw = this->reg[REG_STATUS4];
+    st4.refined.FM_SNR = fmSNR;
+    this->reg[REG_STATUS4] = st4.raw;
+
+    kt09xx_status_8 st8;
+    st8.raw = this->reg[REG_STATUS8];
+    st8.refined.FM_RSSI = fmRSSI;
+    this->reg[REG_STATUS8] = st8.raw;
+
+    kt09xx_am_status_0 am0;
+    am0.raw = this->reg[REG_AMSTATUS0];
+    am0.refined.AM_RSSI = amRSSI;
+    this->reg[REG_AMSTATUS0] = am0.raw;
+
+    kt09xx_am_status_2 am2;
+    am2.raw = this->reg[REG_AMSTATUS2];
+    am2.refined.AM_SNR_MODE1 = amSNR;
+    this->reg[REG_AMSTATUS2] = am2.raw;
+}
+
+/**
+ * @brief Adds a station to the simulated band. Once the table is not empty, every band change (CHANGE_BAND) 
+ * @brief reports the station on the new channel with VALID_TUNE set, or SIM_NOISE_RSSI and VALID_TUNE cleared.
+ */
+void KT0937Sim::addStation(uint16_t channel, uint8_t rssi, uint8_t snr)
+{
+    if (this->stationCount >= SIM_MAX_STATIONS)
+        return;
+    this->stations[this->stationCount].channel = channel;
+    this->stations[this->stationCount].rssi = rssi;
+    this->stations[this->stationCount].snr = snr;
+    this->stationCount++;
+}
+
+void KT0937Sim::clearStations()
+{
+    this->stationCount = 0;
+}
+
+/*
+ * Arduino core stand-in. Time runs on the simulator virtual clock.
+ */
+
+size_t Print::write(const char *str)
+{
+    size_t n = 0;
+    while (*str)
+        n += write((uint8_t) *str++);
+    return n;
+}
+
+size_t Print::printNumber(unsigned long n, uint8_t base)
+{
+    char buf[8 * sizeof(long) + 1];
+    char *str = &buf[sizeof(buf) - 1];
+
+    if (base < 2)
+        base = 10;
+    *str = '\0';
+    do
+    {
+        uint8_t digit = n % base;
+        *--str = digit < 10 ? '0' + digit : 'A' + digit - 10;
+        n /= base;
+    } while (n);
+    return write(str);
+}
+
+size_t Print::print(long n, int base)
+{
+    if (base == DEC && n < 0)
+        return write((uint8_t) '-') + printNumber(-(unsigned long) n, DEC);
+    return printNumber((unsigned long) n, base);
+}
+
+size_t HostSerial::write(uint8_t c)
+{
+    return (fputc(c, stdout) == EOF) ? 0 : 1;
+}
+
+void pinMode(uint8_t, uint8_t) {}
+void digitalWrite(uint8_t, uint8_t) {}
+int digitalRead(uint8_t) { return LOW; }
+
+void delay(unsigned long ms)
+{
+    kt0937Sim.wait(ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    kt0937Sim.wait(us);
+}
+
+unsigned long millis()
+{
+    return kt0937Sim.now() / 1000;
+}
+
+unsigned long micros()
+{
+    return kt0937Sim.now();
+}
+
+/*
+ * Wire stand-in. Bus time: START + address (10 bits), 9 bits per data byte, STOP (1 bit).
+ */
+
+void TwoWire::begin()
+{
+}
+
+void TwoWire::setClock(uint32_t clock)
+{
+    this->clock = clock;
+}
+
+uint32_t TwoWire::getClock()
+{
+    return this->clock;
+}
+
+void TwoWire::beginTransmission(uint8_t address)
+{
+    this->txAddress = address;
+    this->txLength = 0;
+    this->transmitting = true;
+}
+
+size_t TwoWire::write(uint8_t data)
+{
+    if (!this->transmitting || this->txLength >= WIRE_BUFFER_SIZE)
+        return 0;
+    this->txBuffer[this->txLength++] = data;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t n)
+{
+    size_t i = 0;
+    while (i < n && write(data[i]))
+        i++;
+    return i;
+}
+
+/**
+ * @return 0 = success; 2 = address not acknowledged. Like the AVR Wire library.
+ */
+uint8_t TwoWire::endTransmission(bool sendStop)
+{
+    if (!this->transmitting)
+        return 0;   // nothing to send (e.g. after requestFrom)
+    this->transmitting = false;
+
+    kt0937Sim.busTime(this->clock, 10 + 9 * this->txLength + (sendStop ? 1 : 0));
+    kt0937Sim.counters.bytesWritten += this->txLength;
+    this->pendingRepeatedStart = !sendStop;
+    if (sendStop)
+        kt0937Sim.counters.transactions++;
+
+    if (this->txAddress != kt0937Sim.address)
+        return 2;
+
+    if (this->txLength)
+    {
+        kt0937Sim.setPointer(this->txBuffer[0]);
+        for (uint8_t i = 1; i < this->txLength; i++)
+            kt0937Sim.write(this->txBuffer[i]);
+    }
+    return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t n)
+{
+    if (n > WIRE_BUFFER_SIZE)
+        n = WIRE_BUFFER_SIZE;
+
+    kt0937Sim.busTime(this->clock, 10 + 9 * n + 1);
+    kt0937Sim.counters.transactions++;
+    this->pendingRepeatedStart = false;
+
+    this->rxIndex = 0;
+    this->rxLength = 0;
+    if (address != kt0937Sim.address)
+        return 0;
+
+    for (uint8_t i = 0; i < n; i++)
+        this->rxBuffer[i] = kt0937Sim.read();
+    this->rxLength = n;
+    kt0937Sim.counters.bytesRead += n;
+    return n;
+}
+
+int TwoWire::available()
+{
+    return this->rxLength - this->rxIndex;
+}
+
+int TwoWire::read()
+{
+    if (this->rxIndex >= this->rxLength)
+        return -1;
+    return this->rxBuffer[this->rxIndex++];
+}
@@ -0,0 +1,89 @@
+/**
+ * @file KT0937Sim.h
+ * @brief Register level model of the KT0937-D8, for host builds (Linux / CI). See README.md
+ * @details Models the register file (power-on defaults from the kt09xx_* union docs), the read-only status
+ * @details registers, CHANGE_BAND and POWERON_FINISH, and a virtual clock shared with the Arduino.h stand-in
+ * @details (delay, micros...). Bus transactions, bytes and simulated microseconds are counted.
+ */
+
+#ifndef _KT0937_SIM_H
+#define _KT0937_SIM_H
+
+#include <stdint.h>
+#include <KT0937.h>
+
+#define SIM_REG_COUNT           0x100
+#define SIM_XTAL_LOCK_US        200000  // SYS_CFGOK to POWERON_FINISH with a crystal (RCLK_EN = 0)
+#define SIM_RCLK_LOCK_US        5000    // SYS_CFGOK to POWERON_FINISH with an external reference clock (RCLK_EN = 1)
+#define SIM_CHANGE_BAND_US      2000    // CHANGE_BAND set to CHANGE_BAND cleared by the device
+#define SIM_DEVICE_ID           0x82    // DEVICEID0
+#define SIM_MAX_STATIONS        16      // entries of the station table (see addStation)
+#define SIM_NOISE_RSSI          2       // raw RSSI reported on a channel without station
+
+/**
+ * @brief Bus and time counters
+ */
+typedef struct {
+    uint32_t transactions;      //!< START ... STOP sequences (a repeated start does not open a new one)
+    uint32_t bytesWritten;      //!< bytes sent to the device (register pointer included, address byte excluded)
+    uint32_t bytesRead;         //!< bytes received from the device
+    uint32_t busUs;             //!< simulated time on the bus
+    uint32_t waitUs;            //!< simulated time in delay() / delayMicroseconds()
+    uint16_t registerWrites[SIM_REG_COUNT];     //!< bus writes per register (see test.cpp)
+} kt0937_sim_counters;
+
+/**
+ * @brief Station of the simulated band (see KT0937Sim::addStation)
+ */
+typedef struct {
+    uint16_t channel;           //!< RDCHAN units
+    uint8_t rssi;               //!< raw RSSI reported on this channel
+    uint8_t snr;                //!< raw SNR reported on this channel
+} kt0937_sim_station;
+
+class KT0937Sim
+{
+private:
+    uint8_t reg[SIM_REG_COUNT];
+    uint8_t pointer = 0;                //!< register address pointer (auto-increment)
+    uint32_t nowUs = 0;                 //!< virtual clock
+    uint32_t powerOnAt = 0;             //!< when POWERON_FINISH is set (0 = not scheduled)
+    uint32_t changeBandAt = 0;          //!< when CHANGE_BAND is cleared (0 = not scheduled)
+    kt0937_sim_station stations[SIM_MAX_STATIONS];
+    uint8_t stationCount = 0;           //!< 0 = the signal is the one set with setSignal
+
+    bool isReadOnly(uint8_t r);
+    void writeRegister(uint8_t r, uint8_t value);
+    void update();
+
+public:
+    uint8_t address = KT0937_I2C_ADDRESS;
+    kt0937_sim_counters counters;
+
+    KT0937Sim();
+    void powerOn();
+    void resetCounters();
+
+    // virtual clock
+    uint32_t now();
+    void advance(uint32_t us);
+    void wait(uint32_t us);
+
+    // bus side (used by the Wire stand-in)
+    void busTime(uint32_t clock, uint16_t bits);
+    void setPointer(uint8_t r);
+    void write(uint8_t value);
+    uint8_t read();
+
+    // test side: direct access, no bus accounting and no side effect
+    uint8_t peek(uint8_t r);
+    void poke(uint8_t r, uint8_t value);
+    void setChannel(uint16_t channel);
+    void setSignal(uint8_t fmRSSI, uint8_t fmSNR, uint8_t amRSSI, uint8_t amSNR, bool valid, bool stereo);
+    void addStation(uint16_t channel, uint8_t rssi, uint8_t snr);
+    void clearStations();
+};
+
+extern KT0937Sim kt0937Sim;
+
+#endif // _KT0937_SIM_H
@@ -0,0 +1,49 @@
+/**
+ * @file Wire.h
+ * @brief Host build stand-in for the Arduino Wire library. See README.md
+ * @details Every transaction is routed to the simulated KT0937 (KT0937Sim), which accounts for the bus
+ * @details time at the configured clock (setClock) and counts transactions and bytes.
+ */
+
+#ifndef _KT0937_HOST_WIRE_H
+#define _KT0937_HOST_WIRE_H
+
+#include <Arduino.h>
+
+#define WIRE_BUFFER_SIZE 32     // same as the AVR Wire library
+
+class TwoWire
+{
+private:
+    uint8_t txAddress = 0;
+    uint8_t txBuffer[WIRE_BUFFER_SIZE];
+    uint8_t txLength = 0;
+    bool transmitting = false;
+    bool pendingRepeatedStart = false;      //!< endTransmission(false): the next requestFrom is in the same transaction
+
+    uint8_t rxBuffer[WIRE_BUFFER_SIZE];
+    uint8_t rxLength = 0;
+    uint8_t rxIndex = 0;
+
+    uint32_t clock = 100000;
+
+public:
+    void begin();
+    void setClock(uint32_t clock);
+    uint32_t getClock();
+
+    void beginTransmission(uint8_t address);
+    void beginTransmission(int address) { beginTransmission((uint8_t) address); }
+    size_t write(uint8_t data);
+    size_t write(const uint8_t *data, size_t n);
+    uint8_t endTransmission(bool sendStop = true);
+
+    uint8_t requestFrom(uint8_t address, uint8_t n);
+    uint8_t requestFrom(int address, int n) { return requestFrom((uint8_t) address, (uint8_t) n); }
+    int available();
+    int read();
+};
+
+extern TwoWire Wire;
+
+#endif // _KT0937_HOST_WIRE_H
@@ -0,0 +1,88 @@
+/**
+ * @file benchmark.cpp
+ * @brief Bus cost and latency of the KT0937 control path, on the simulated KT0937. See README.md
+ * @details Prints one tab separated row per case: I2C transactions, bytes written and read, simulated bus
+ * @details time, simulated delay time and total simulated time. Everything is deterministic, so two reports
+ * @details can be compared with diff.
+ * @details The cases run in the order of the table, on the same radio (the state left by a case is the
+ * @details starting point of the next one).
+ *
+ * Build and run, from the repository root:
+ *
+ *     g++ -std=gnu++11 -Iextras/host -Isrc src/KT0937.cpp extras/host/KT0937Sim.cpp extras/host/benchmark.cpp -o kt0937_benchmark
+ *     ./kt0937_benchmark [I2C clock in Hz, default 100000]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <KT0937.h>
+#include "KT0937Sim.h"
+
+typedef struct {
+    const char *name;
+    void (*run)(KT0937 &radio);
+} benchmark_case;
+
+static const benchmark_case cases[] = {
+    {"setup",                   [](KT0937 &radio) { radio.setup(); }},
+    {"setSystemClock",          [](KT0937 &radio) { radio.setSystemClock(); }},
+    {"setFMBand",               [](KT0937 &radio) { radio.setFMBand(); }},
+    {"setFMBand.again",         [](KT0937 &radio) { radio.setFMBand(); }},
+    {"setAMBand",               [](KT0937 &radio) { radio.setAMBand(); }},
+    {"setSWBand(9400,9900,500)",[](KT0937 &radio) { radio.setSWBand(9400, 9900, 500); }},
+    {"setSWBand(9900,10400,500)",[](KT0937 &radio) { radio.setSWBand(9900, 10400, 500); }},
+    {"setFMBand.fromSW",        [](KT0937 &radio) { radio.setFMBand(); }},
+    {"queueBand+poll",          [](KT0937 &radio) { kt09xx_band_image image; radio.getBandImage(KT0937_MW_BAND, image);
+                                                    radio.queueBand(image); while (!radio.poll()) kt0937Sim.advance(100); }},
+    {"setFMBand.fromMW",        [](KT0937 &radio) { radio.setFMBand(); }},
+    {"seekUp",                  [](KT0937 &radio) { radio.seekUp(); }},
+    {"scanBand",                [](KT0937 &radio) { kt09xx_station stations[8]; radio.scanBand(stations, 8); }},
+    {"setSWBand(9400,9900,500)", [](KT0937 &radio) { radio.setSWBand(9400, 9900, 500); }},
+    {"sweepBand.rssi",          [](KT0937 &radio) { static uint8_t rssi[501]; radio.sweepBand(rssi, NULL, sizeof(rssi)); }},
+    {"sweepBand.rssi+snr",      [](KT0937 &radio) { static uint8_t rssi[501], snr[501]; radio.sweepBand(rssi, snr, sizeof(rssi)); }},
+    {"suspend",                 [](KT0937 &radio) { radio.suspend(); }},
+    {"resume.warm",             [](KT0937 &radio) { radio.resume(); }},
+    {"resume.cold",             [](KT0937 &radio) { radio.suspend(); kt0937Sim.powerOn(); radio.resume(); }},
+    {"setVolume",               [](KT0937 &radio) { radio.setVolume(20); }},
+    {"setVolume.same",          [](KT0937 &radio) { radio.setVolume(20); }},
+    {"service.setVolume*10",    [](KT0937 &radio) { static KT0937Service service(radio);
+                                                    for (int8_t v = 10; v < 20; v++) service.setVolume(v);
+                                                    service.poll(); }},
+    {"getRSSI",                 [](KT0937 &radio) { radio.getRSSI(); }},
+    {"getSNR",                  [](KT0937 &radio) { radio.getSNR(); }},
+    {"getCurrentFrequency",     [](KT0937 &radio) { radio.getCurrentFrequency(); }},
+    {"readStatus",              [](KT0937 &radio) { kt09xx_signal_status status; radio.readStatus(status); }},
+    {"pollTelemetry.10s",       [](KT0937 &radio) { radio.onTelemetry([](const kt09xx_signal_status &, uint8_t) {});
+                                                    for (int ms = 0; ms < 10000; ms++) { radio.pollTelemetry(); kt0937Sim.advance(1000); }
+                                                    radio.onTelemetry(NULL); }},
+};
+
+int main(int argc, char **argv)
+{
+    KT0937 radio;
+    uint32_t clock = (argc > 1) ? strtoul(argv[1], NULL, 10) : 100000;
+
+    radio.setI2CBus(Wire, clock);
+    kt0937Sim.setSignal(40, 20, 30, 10, true, true);
+    kt0937Sim.addStation(1762, 45, 30);     // 88.1MHz
+    kt0937Sim.addStation(1962, 60, 40);     // 98.1MHz
+    kt0937Sim.addStation(2054, 35, 25);     // 102.7MHz
+
+    printf("case\ttransactions\tbytes_written\tbytes_read\tbus_us\twait_us\ttotal_us\n");
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        kt0937Sim.resetCounters();
+        uint32_t start = kt0937Sim.now();
+        cases[i].run(radio);
+        uint32_t total = kt0937Sim.now() - start;
+
+        printf("%s\t%lu\t%lu\t%lu\t%lu\t%lu\t%lu\n", cases[i].name,
+               (unsigned long) kt0937Sim.counters.transactions,
+               (unsigned long) kt0937Sim.counters.bytesWritten,
+               (unsigned long) kt0937Sim.counters.bytesRead,
+               (unsigned long) kt0937Sim.counters.busUs,
+               (unsigned long) kt0937Sim.counters.waitUs,
+               (unsigned long) total);
+    }
+    return 0;
+}
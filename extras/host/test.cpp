@@ -0,0 +1,624 @@
+/**
+ * @file test.cpp
+ * @brief Functional checks of the KT0937 library on the simulated KT0937. See README.md
+ * @details Each case starts from a powered-on simulator and a radio after setup(), and checks the state of the
+ * @details simulated device (registers, bus writes) and the values returned by the library. Prints one line per
+ * @details failed check and a summary; the exit code is the number of failed checks (0 = pass), for CI.
+ *
+ * Build and run, from the repository root:
+ *
+ *     g++ -std=gnu++11 -Iextras/host -Isrc src/KT0937.cpp extras/host/KT0937Sim.cpp extras/host/test.cpp -o kt0937_test
+ *     ./kt0937_test
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <KT0937.h>
+#include "KT0937Sim.h"
+#if KT0937_LOCK == KT0937_LOCK_STD
+#include <atomic>
+#include <thread>
+#endif
+
+static unsigned checks = 0;
+static unsigned failures = 0;
+
+#define CHECK(condition) check((condition), #condition, __FILE__, __LINE__)
+#define CHECK_EQUAL(actual, expected) checkEqual((long) (actual), (long) (expected), #actual, __FILE__, __LINE__)
+
+static void check(bool condition, const char *text, const char *file, int line)
+{
+    checks++;
+    if (condition)
+        return;
+    failures++;
+    printf("%s:%d: CHECK(%s) failed\n", file, line, text);
+}
+
+static void checkEqual(long actual, long expected, const char *text, const char *file, int line)
+{
+    checks++;
+    if (actual == expected)
+        return;
+    failures++;
+    printf("%s:%d: %s is %ld, expected %ld\n", file, line, text, actual, expected);
+}
+
+/**
+ * @brief Registers of a band switch, in the order of bandRegisters in KT0937.cpp
+ */
+static const uint8_t bandRegisters[BAND_REG_COUNT] = {
+    REG_BANDCFG0, REG_BANDCFG2, REG_BANDCFG3, REG_ADC3, REG_ADC4, REG_FMCHAN0, REG_FMCHAN1,
+    REG_AMCHAN0, REG_AMCHAN1, REG_LOW_CHAN0, REG_LOW_CHAN1, REG_CHAN_NUM0, REG_CHAN_NUM1, REG_GUARD2
+};
+
+/**
+ * @brief Station storage in RAM, for KT0937StationStore
+ * @details powerLeft >= 0 simulates a power loss: that many write / erase calls are done, the next ones are dropped.
+ */
+class RamStorage : public KT0937Storage
+{
+public:
+    uint8_t bytes[64];
+    int powerLeft = -1;
+
+    RamStorage() { memset(this->bytes, 0xFF, sizeof(this->bytes)); }
+    uint16_t size() { return sizeof(this->bytes); }
+    bool read(uint16_t address, uint8_t *buf, uint16_t n) { memcpy(buf, &this->bytes[address], n); return true; }
+    bool write(uint16_t address, const uint8_t *buf, uint16_t n)
+    {
+        if (!powered())
+            return false;
+        memcpy(&this->bytes[address], buf, n);
+        return true;
+    }
+    bool erase(uint16_t address, uint16_t n)
+    {
+        if (!powered())
+            return false;
+        memset(&this->bytes[address], 0xFF, n);
+        return true;
+    }
+
+private:
+    bool powered()
+    {
+        if (this->powerLeft == 0)
+            return false;
+        if (this->powerLeft > 0)
+            this->powerLeft--;
+        return true;
+    }
+};
+
+/**
+ * @brief Station entry number n of the store tests
+ */
+static kt09xx_station_entry makeEntry(uint16_t n)
+{
+    kt09xx_station_entry entry;
+    entry.band = n & 0x7F;
+    entry.channel = 1000 + n;
+    entry.volume = n % 32;
+    entry.flags = STATION_FLAG_CHANNEL;
+    return entry;
+}
+
+/**
+ * @brief Last station found by a new store on the storage (as after a reset). 0xFFFF = none
+ */
+static uint16_t loadLastChannel(RamStorage &storage, uint8_t presets)
+{
+    kt09xx_station_entry loaded;
+    KT0937StationStore store(storage, presets);
+    if (!store.begin() || !store.loadStation(loaded))
+        return 0xFFFF;
+    return loaded.channel;
+}
+
+static uint8_t callbackTags[8];
+static uint8_t callbackErrors[8];
+static uint8_t callbackCount = 0;
+
+static void recordCallback(uint8_t tag, uint8_t errorCode)
+{
+    if (callbackCount < sizeof(callbackTags))
+    {
+        callbackTags[callbackCount] = tag;
+        callbackErrors[callbackCount] = errorCode;
+    }
+    callbackCount++;
+}
+
+/**
+ * @brief Waits (virtual clock) until the device has cleared CHANGE_BAND
+ */
+static void settle()
+{
+    kt0937Sim.advance(SIM_CHANGE_BAND_US);
+}
+
+static void testShadowCache(KT0937 &radio)
+{
+    //write-through: a written config register is read from the shadow map
+    radio.setVolume(20);
+    kt0937Sim.resetCounters();
+    CHECK_EQUAL(radio.getCachedRegister(REG_RXCFG1) & 0x1F, 20);
+    CHECK_EQUAL(kt0937Sim.counters.transactions, 0);
+
+    //a register never accessed is read once
+    kt0937Sim.poke(REG_SOUNDCFG, 0x5A);
+    CHECK_EQUAL(radio.getCachedRegister(REG_SOUNDCFG), 0x5A);
+    CHECK_EQUAL(radio.getCachedRegister(REG_SOUNDCFG), 0x5A);
+    CHECK_EQUAL(kt0937Sim.counters.transactions, 1);
+
+    //status registers are always read from the device
+    kt0937Sim.setSignal(33, 20, 30, 10, true, true);
+    CHECK_EQUAL(radio.getRegister(REG_STATUS8), 33);
+    kt0937Sim.setSignal(34, 20, 30, 10, true, true);
+    CHECK_EQUAL(radio.getRegister(REG_STATUS8), 34);
+
+    //trigger bits are not kept, so they are written again
+    radio.setFMBand();
+    settle();
+    kt0937Sim.resetCounters();
+    CHECK_EQUAL(radio.getCachedRegister(REG_FMCHAN0) & 0x80, 0);        // CHANGE_BAND
+    CHECK_EQUAL(radio.getCachedRegister(REG_ADC0) & 0x04, 0);           // CH_ADC_START
+    CHECK_EQUAL(kt0937Sim.counters.transactions, 0);
+
+    uint8_t adc0 = radio.getCachedRegister(REG_ADC0) | 0x04;
+    radio.setRegister(REG_ADC0, adc0);
+    radio.setRegister(REG_ADC0, adc0);
+    CHECK_EQUAL(kt0937Sim.counters.registerWrites[REG_ADC0], 2);
+}
+
+static void testBandDelta(KT0937 &radio)
+{
+    uint8_t before[BAND_REG_COUNT];
+
+    radio.setSWBand(9400, 9900, 500);
+    settle();
+    for (uint8_t i = 0; i < BAND_REG_COUNT; i++)
+        before[i] = kt0937Sim.peek(bandRegisters[i]);
+
+    kt0937Sim.resetCounters();
+    radio.setSWBand(9900, 10400, 500);
+    settle();
+    for (uint8_t i = 0; i < BAND_REG_COUNT; i++)
+    {
+        uint8_t r = bandRegisters[i];
+        if (r == REG_FMCHAN0)
+            CHECK_EQUAL(kt0937Sim.counters.registerWrites[r], 1);       // CHANGE_BAND
+        else
+            CHECK_EQUAL(kt0937Sim.counters.registerWrites[r], before[i] != kt0937Sim.peek(r) ? 1 : 0);
+    }
+    CHECK_EQUAL(kt0937Sim.peek(REG_LOW_CHAN0) << 8 | kt0937Sim.peek(REG_LOW_CHAN1), 9900);
+
+    //same band again: only CHANGE_BAND and the ADC of CH pin
+    kt0937Sim.resetCounters();
+    radio.setSWBand(9900, 10400, 500);
+    settle();
+    for (uint8_t i = 0; i < BAND_REG_COUNT; i++)
+        if (bandRegisters[i] != REG_FMCHAN0)
+            CHECK_EQUAL(kt0937Sim.counters.registerWrites[bandRegisters[i]], 0);
+    CHECK_EQUAL(kt0937Sim.counters.registerWrites[REG_FMCHAN0], 1);
+    CHECK_EQUAL(kt0937Sim.counters.registerWrites[REG_ADC0], 2);
+}
+
+static void testSeekRange(KT0937 &radio)
+{
+    kt09xx_band_image image;
+    kt09xx_station station;
+
+    //a queued band switch sets the seek range of the new band
+    radio.setFMBand();
+    settle();
+    uint32_t fmKHz = radio.getCurrentFrequencyKHz();
+    radio.getBandImage(KT0937_MW_BAND, image);
+    CHECK(radio.queueBand(image));
+    CHECK_EQUAL(radio.getCurrentFrequencyKHz(), fmKHz);         // not switched yet
+    CHECK(!radio.poll());
+    CHECK_EQUAL(radio.getCurrentFrequencyKHz(), fmKHz);         // CHANGE_BAND not cleared yet
+    while (!radio.poll())
+        kt0937Sim.advance(100);
+
+    uint16_t low = kt0937Sim.peek(REG_LOW_CHAN0) << 8 | kt0937Sim.peek(REG_LOW_CHAN1);
+    CHECK_EQUAL(radio.getCurrentFrequencyKHz(), low);           // MW: 1kHz channels
+    uint16_t step = radio.getChannelStep();
+    kt0937Sim.addStation(low + 20 * step, 40, 20);
+    CHECK(radio.seekUp(&station));
+    CHECK_EQUAL(station.channel, low + 20 * step);
+    CHECK_EQUAL(radio.getErrorCode(), ERR_OK);
+
+    //scan and a failed seek give the band back, not a single channel
+    uint8_t before[BAND_REG_COUNT];
+    radio.setAMBand();
+    settle();
+    for (uint8_t i = 0; i < BAND_REG_COUNT; i++)
+        before[i] = kt0937Sim.peek(bandRegisters[i]);
+
+    kt09xx_station stations[4];
+    CHECK_EQUAL(radio.scanBand(stations, 4), 1);
+    settle();
+    for (uint8_t i = 0; i < BAND_REG_COUNT; i++)
+        CHECK_EQUAL(kt0937Sim.peek(bandRegisters[i]), before[i]);
+
+    kt0937Sim.clearStations();
+    CHECK(!radio.seekUp(&station));
+    CHECK_EQUAL(radio.getErrorCode(), ERR_SEEK);
+    settle();
+    for (uint8_t i = 0; i < BAND_REG_COUNT; i++)
+        CHECK_EQUAL(kt0937Sim.peek(bandRegisters[i]), before[i]);
+}
+
+static void testQueue(KT0937 &radio)
+{
+    kt09xx_band_image image;
+
+    //a write with a settling time holds back the next one
+    CHECK(radio.queueRegister(REG_RXCFG0, 0x10, 0x10));                  // DSP_RST
+    CHECK(radio.queueRegister(REG_RXCFG0, 0x00, 0x10));
+    CHECK(!radio.poll());
+    CHECK_EQUAL(kt0937Sim.peek(REG_RXCFG0) & 0x10, 0x10);
+    kt0937Sim.advance(DSP_RST_SETTLE_US / 2);
+    CHECK(!radio.poll());
+    CHECK_EQUAL(kt0937Sim.peek(REG_RXCFG0) & 0x10, 0x10);
+    kt0937Sim.advance(DSP_RST_SETTLE_US);
+    CHECK(radio.poll());
+    CHECK_EQUAL(kt0937Sim.peek(REG_RXCFG0) & 0x10, 0);
+
+    //a register already holding its value is not written
+    radio.setVolume(12);
+    kt0937Sim.resetCounters();
+    CHECK(radio.queueVolume(12));
+    CHECK(radio.poll());
+    CHECK_EQUAL(kt0937Sim.counters.transactions, 0);
+
+    //band switch: waits for the device to clear CHANGE_BAND, then runs the rest
+    callbackCount = 0;
+    radio.setFMBand();
+    settle();
+    uint32_t fmKHz = radio.getCurrentFrequencyKHz();
+    radio.getBandImage(KT0937_MW_BAND, image);
+    CHECK(radio.queueBand(image, recordCallback, 7));
+    CHECK(radio.queueVolume(20));
+    CHECK(!radio.poll());
+    CHECK_EQUAL(radio.getCurrentFrequencyKHz(), fmKHz);
+    CHECK_EQUAL(kt0937Sim.peek(REG_FMCHAN0) & 0x80, 0x80);
+    CHECK_EQUAL(callbackCount, 0);
+    CHECK((kt0937Sim.peek(REG_RXCFG1) & 0x1F) != 20);
+    settle();
+    CHECK(radio.poll());
+    CHECK_EQUAL(callbackCount, 1);
+    CHECK_EQUAL(callbackTags[0], 7);
+    CHECK_EQUAL(callbackErrors[0], ERR_OK);
+    CHECK_EQUAL(radio.getCurrentFrequencyKHz(), kt0937Sim.peek(REG_LOW_CHAN0) << 8 | kt0937Sim.peek(REG_LOW_CHAN1));
+    CHECK_EQUAL(kt0937Sim.peek(REG_RXCFG1) & 0x1F, 20);
+    CHECK_EQUAL(radio.getQueueFree(), KT0937_QUEUE_SIZE);
+
+    //readiness flag timeout: CHANGE_BAND stuck at 1
+    callbackCount = 0;
+    radio.getBandImage(KT0937_FM_BAND, image);
+    CHECK(radio.queueBand(image, recordCallback, 8));
+    CHECK(!radio.poll());
+    settle();
+    kt0937Sim.poke(REG_FMCHAN0, kt0937Sim.peek(REG_FMCHAN0) | 0x80);
+    CHECK(!radio.poll());
+    kt0937Sim.advance(CHANGE_BAND_TIMEOUT_MS * 1000UL);
+    CHECK(radio.poll());
+    CHECK_EQUAL(callbackCount, 1);
+    CHECK_EQUAL(callbackErrors[0], ERR_CHANGE_BAND);
+}
+
+static void testService(KT0937 &radio)
+{
+    KT0937Service service(radio);
+    kt09xx_band_image image;
+
+    //ten volume changes, one write
+    kt0937Sim.resetCounters();
+    for (int8_t v = 10; v < 20; v++)
+        CHECK(service.setVolume(v));
+    service.poll();
+    CHECK_EQUAL(kt0937Sim.counters.registerWrites[REG_RXCFG1], 1);
+    CHECK_EQUAL(kt0937Sim.peek(REG_RXCFG1) & 0x1F, 19);
+    CHECK_EQUAL(service.getCoalescedCount(), 9);
+
+    //priority order, and a band switch drops the tune posted before it
+    callbackCount = 0;
+    service.onCompleted(recordCallback);
+    radio.getBandImage(KT0937_MW_BAND, image);
+    service.requestStatus();
+    service.setChannel(1000);
+    service.setBand(image);
+    service.setVolume(5);
+    service.setMute(true);
+    service.poll();
+    CHECK_EQUAL(callbackCount, 4);
+    CHECK_EQUAL(callbackTags[0], SERVICE_MUTE);
+    CHECK_EQUAL(callbackTags[1], SERVICE_VOLUME);
+    CHECK_EQUAL(callbackTags[2], SERVICE_BAND);
+    CHECK_EQUAL(callbackTags[3], SERVICE_STATUS);
+    CHECK(radio.isMuted());
+    CHECK_EQUAL(kt0937Sim.peek(REG_RXCFG1) & 0x1F, 0);
+
+    //a tune posted after a band switch waits for it
+    callbackCount = 0;
+    service.setBand(image);
+    service.setChannel(1000);
+    service.poll();
+    CHECK_EQUAL(callbackCount, 2);
+    CHECK_EQUAL(callbackTags[0], SERVICE_BAND);
+    CHECK_EQUAL(callbackTags[1], SERVICE_TUNE);
+}
+
+static void testStationStore(KT0937 &)
+{
+    RamStorage storage;
+    kt09xx_station_entry entry, loaded;
+    const uint8_t presets = 2;
+    const uint16_t slots = (sizeof(storage.bytes) - presets * STATION_ENTRY_SIZE) / STATION_ENTRY_SIZE;
+    const uint16_t half = slots / 2;
+
+    KT0937StationStore empty(storage, presets);
+    CHECK(empty.begin());
+    CHECK(!empty.loadStation(loaded));
+
+    //begin() finds the last station at every fill level of the log, across two wraps
+    for (uint16_t i = 0; i < 2 * slots + 3; i++)
+    {
+        KT0937StationStore writer(storage, presets);
+        CHECK(writer.begin());
+        entry = makeEntry(i);
+        CHECK(writer.saveStation(entry));
+
+        KT0937StationStore reader(storage, presets);
+        CHECK(reader.begin());
+        CHECK(reader.loadStation(loaded));
+        CHECK_EQUAL(loaded.band, entry.band);
+        CHECK_EQUAL(loaded.channel, entry.channel);
+        CHECK_EQUAL(loaded.volume, entry.volume);
+        CHECK_EQUAL(loaded.flags, entry.flags);
+
+        //the other half is erased, and so is the rest of this one
+        uint16_t last = i % (2 * half);
+        uint16_t other = (last < half) ? half : 0;
+        CHECK_EQUAL(storage.bytes[(presets + other) * STATION_ENTRY_SIZE + 1], 0xFF);
+        if ((last + 1) % half)
+            CHECK_EQUAL(storage.bytes[(presets + last + 1) * STATION_ENTRY_SIZE + 1], 0xFF);
+    }
+
+    //power loss during the save that starts a new half: the new or the previous station, never none
+    for (int cut = 0; cut <= 2; cut++)
+    {
+        RamStorage flash;
+        KT0937StationStore store(flash, presets);
+        CHECK(store.begin());
+        for (uint16_t i = 0; i < half; i++)
+            CHECK(store.saveStation(makeEntry(i)));
+
+        flash.powerLeft = cut;                          // 0: nothing; 1: entry written; 2: older half erased
+        CHECK_EQUAL(store.saveStation(makeEntry(half)), cut == 2);
+        flash.powerLeft = -1;
+        CHECK_EQUAL(loadLastChannel(flash, presets), makeEntry(cut ? half : half - 1).channel);
+
+        //after the reset the log goes on, and the interrupted erase is done by the next save
+        KT0937StationStore restarted(flash, presets);
+        CHECK(restarted.begin());
+        for (uint16_t i = half + 1; i < 3 * half + 1; i++)
+        {
+            CHECK(restarted.saveStation(makeEntry(i)));
+            CHECK_EQUAL(loadLastChannel(flash, presets), makeEntry(i).channel);
+        }
+    }
+
+    //presets are not touched by the log
+    KT0937StationStore store(storage, presets);
+    CHECK(store.begin());
+    entry.band = 3;
+    entry.channel = 1962;
+    entry.volume = 20;
+    entry.flags = 0;
+    CHECK(store.savePreset(1, entry));
+    for (uint16_t i = 0; i < slots + 1; i++)
+    {
+        entry.channel = 500 + i;
+        store.saveStation(entry);
+    }
+    CHECK(store.loadPreset(1, loaded));
+    CHECK_EQUAL(loaded.channel, 1962);
+    CHECK(!store.loadPreset(0, loaded));
+}
+
+static void testSuspendResume(KT0937 &radio)
+{
+    uint8_t before[REG_STATUS0];
+
+    radio.setAMBand();
+    settle();
+    radio.setVolume(25);
+    for (int r = 0; r < REG_STATUS0; r++)
+        before[r] = kt0937Sim.peek(r);
+
+    //warm: the key registers are retained, the clock is not configured again
+    radio.suspend();
+    kt0937Sim.resetCounters();
+    CHECK_EQUAL(radio.resume(), ERR_OK);
+    CHECK_EQUAL(kt0937Sim.counters.registerWrites[REG_PLLCFG0], 0);
+    CHECK_EQUAL(kt0937Sim.counters.registerWrites[REG_FMCHAN0], 0);
+    kt0937Sim.advance(STDBY_SETTLE_US);
+    for (int r = 0; r < REG_STATUS0; r++)
+        CHECK_EQUAL(kt0937Sim.peek(r), before[r]);
+
+    //checksum mismatch: a key register changed during standby is written back
+    radio.suspend();
+    kt0937Sim.poke(REG_LOW_CHAN1, kt0937Sim.peek(REG_LOW_CHAN1) ^ 0x01);
+    CHECK_EQUAL(radio.resume(), ERR_OK);
+    settle();
+    for (int r = 0; r < REG_STATUS0; r++)
+        CHECK_EQUAL(kt0937Sim.peek(r), before[r]);
+
+    //cold: the device lost everything
+    radio.suspend();
+    kt0937Sim.powerOn();
+    kt0937Sim.resetCounters();
+    CHECK_EQUAL(radio.resume(), ERR_OK);
+    CHECK(kt0937Sim.counters.registerWrites[REG_PLLCFG0] > 0);
+    settle();
+    for (int r = REG_PLLCFG0; r < REG_STATUS0; r++)
+        CHECK_EQUAL(kt0937Sim.peek(r), before[r]);
+}
+
+static void testSignalFilters(KT0937 &radio)
+{
+    static const uint8_t rssi[] = {20, 22, 21, 80, 23};     // one spike
+    kt09xx_signal_stats stats;
+
+    radio.setFMBand();
+    settle();
+    radio.clearSignalHistory();
+    CHECK(!radio.getSignalStats(MODE_FM, SIGNAL_RSSI, stats));
+
+    for (uint8_t i = 0; i < sizeof(rssi); i++)
+    {
+        kt0937Sim.setSignal(rssi[i], 20, 30, 10, true, true);
+        radio.getFMRSSI();
+    }
+    CHECK(radio.getSignalStats(MODE_FM, SIGNAL_RSSI, stats));
+    CHECK_EQUAL(stats.count, 5);
+    CHECK_EQUAL(stats.last, 23 + RSSI_DBUVEMF_OFFSET);
+    CHECK_EQUAL(stats.min, 20 + RSSI_DBUVEMF_OFFSET);
+    CHECK_EQUAL(stats.max, 80 + RSSI_DBUVEMF_OFFSET);
+    CHECK_EQUAL(stats.median, 22 + RSSI_DBUVEMF_OFFSET);   // the spike is ignored
+    CHECK_EQUAL(stats.mean, 36);                            // (23 + 25 + 24 + 83 + 26 + 2) / 5
+    CHECK_EQUAL(stats.ema, 35);                             // 8.8 fixed point, SIGNAL_EMA_SHIFT 2
+
+    //even count: rounded average of the two middle samples
+    kt0937Sim.setSignal(24, 20, 30, 10, true, true);
+    radio.getFMRSSI();
+    CHECK(radio.getSignalStats(MODE_FM, SIGNAL_RSSI, stats));
+    CHECK_EQUAL(stats.median, 23 + RSSI_DBUVEMF_OFFSET);   // (25 + 26 + 1) / 2
+
+    //the ring keeps the last KT0937_HISTORY_SIZE samples
+    for (uint8_t i = 0; i < KT0937_HISTORY_SIZE; i++)
+        radio.getFMRSSI();
+    CHECK(radio.getSignalStats(MODE_FM, SIGNAL_RSSI, stats));
+    CHECK_EQUAL(stats.count, KT0937_HISTORY_SIZE);
+    CHECK_EQUAL(stats.median, 24 + RSSI_DBUVEMF_OFFSET);
+    CHECK_EQUAL(stats.max, 24 + RSSI_DBUVEMF_OFFSET);
+
+    //a tune clears the history
+    radio.setChannel(1962);
+    radio.getFMRSSI();
+    CHECK(radio.getSignalStats(MODE_FM, SIGNAL_RSSI, stats));
+    CHECK_EQUAL(stats.count, 1);
+}
+
+static void testTuneEvents(KT0937 &radio)
+{
+    //the ring keeps KT0937_EVENT_SIZE - 1 interrupts; the others are counted
+    for (uint8_t i = 0; i < KT0937_EVENT_SIZE + 2; i++)
+        radio.onTuneInterrupt();
+    CHECK_EQUAL(radio.getTuneEventOverflow(), 3);
+
+    //nothing is serviced while the dial moves
+    CHECK(!radio.serviceTuneEvents());
+    CHECK_EQUAL(radio.getTuneEventOverflow(), 3);
+
+    kt0937Sim.setChannel(1962);
+    kt0937Sim.advance(KT0937_EVENT_QUIET_US);
+    CHECK(radio.serviceTuneEvents());
+    CHECK_EQUAL(radio.getTuneEventOverflow(), 0);
+    CHECK_EQUAL(radio.getCurrentChannel(), 1962);
+
+    //the counter restarts from the service, and saturates
+    for (uint16_t i = 0; i < 300; i++)
+        radio.onTuneInterrupt();
+    CHECK_EQUAL(radio.getTuneEventOverflow(), 0xFF);
+    kt0937Sim.advance(KT0937_EVENT_QUIET_US);
+    CHECK(!radio.serviceTuneEvents());                                  // same channel: no callback
+    CHECK_EQUAL(radio.getTuneEventOverflow(), 0);
+}
+
+#if KT0937_LOCK == KT0937_LOCK_STD
+static void testThreads(KT0937 &radio)
+{
+    //band switches on one thread, status reads on another: the shadow map must match the device afterwards
+    std::atomic<bool> started(false);
+    std::atomic<bool> done(false);
+    std::thread reader([&]() {
+        kt09xx_signal_status status;
+        started = true;
+        while (!done)
+        {
+            radio.readStatus(status);
+            radio.getFMRSSI();
+        }
+    });
+    while (!started)
+        std::this_thread::yield();
+    for (int i = 0; i < 48; i++)
+    {
+        if (i % 3 == 0)
+            radio.setFMBand();
+        else if (i % 3 == 1)
+            radio.setAMBand();
+        else
+            radio.setSWBand(9400 + (i % 5) * 100, 9900 + (i % 5) * 100, 500);
+    }
+    done = true;
+    reader.join();
+    settle();
+
+    for (uint8_t i = 0; i < BAND_REG_COUNT; i++)
+    {
+        uint8_t r = bandRegisters[i];
+        uint8_t trigger = (r == REG_FMCHAN0) ? 0x80 : 0x00;           // CHANGE_BAND
+        CHECK_EQUAL(radio.getCachedRegister(r) & ~trigger, kt0937Sim.peek(r) & ~trigger);
+    }
+    CHECK_EQUAL(kt0937Sim.peek(REG_LOW_CHAN0) << 8 | kt0937Sim.peek(REG_LOW_CHAN1), 9600);          // last switch: i = 47
+    CHECK_EQUAL(radio.getErrorCode(), ERR_OK);
+}
+#endif
+
+typedef struct {
+    const char *name;
+    void (*run)(KT0937 &radio);
+} test_case;
+
+static const test_case cases[] = {
+    {"shadow cache",            testShadowCache},
+    {"band delta",              testBandDelta},
+    {"seek range",              testSeekRange},
+    {"command queue",           testQueue},
+    {"service",                 testService},
+    {"station store",           testStationStore},
+    {"suspend / resume",        testSuspendResume},
+    {"signal filters",          testSignalFilters},
+    {"tune events",             testTuneEvents},
+#if KT0937_LOCK == KT0937_LOCK_STD
+    {"threads",                 testThreads},
+#endif
+};
+
+int main()
+{
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        KT0937 radio;
+        unsigned failed = failures;
+
+        kt0937Sim.powerOn();
+        kt0937Sim.clearStations();
+        kt0937Sim.setSignal(40, 20, 30, 10, true, true);
+        radio.setup();
+        settle();
+        kt0937Sim.resetCounters();
+
+        cases[i].run(radio);
+        printf("%s\t%s\n", (failures == failed) ? "pass" : "FAIL", cases[i].name);
+    }
+
+    printf("%u checks, %u failed\n", checks, failures);
+    return failures ? 1 : 0;
+}
@@ -18,21 +18,144 @@
 
 
 
+/**
+ * @ingroup GA03
+ * @brief Register timing policy table 
+ * @details Only the writes listed here wait for the device. See kt09xx_timing_policy.
+ */
+static const kt09xx_timing_policy timingPolicy[] = {
+    // reg          mask  edge               settleUs             flagReg        flagMask flagState timeoutMs               pollUs                  errorCode
+    { REG_RXCFG0,   0x20, SETTLE_ON_CHANGE,  STDBY_SETTLE_US,     0,             0x00,    0x00,     0,                      0,                      ERR_OK },           // STDBY
+    { REG_RXCFG0,   0x10, SETTLE_ON_SET,     DSP_RST_SETTLE_US,   0,             0x00,    0x00,     0,                      0,                      ERR_OK },           // DSP_RST
+    { REG_PLLCFG0,  0x80, SETTLE_ON_SET,     0,                   REG_G38KCFG0,  0x04,    0x04,     POWERON_TIMEOUT_MS,     POWERON_POLL_MS * 1000, ERR_CLK },          // SYS_CFGOK -> POWERON_FINISH
+    { REG_FMCHAN0,  0x80, SETTLE_ON_SET,     0,                   REG_FMCHAN0,   0x80,    0x00,     CHANGE_BAND_TIMEOUT_MS, CHANGE_BAND_POLL_US,    ERR_CHANGE_BAND }  // CHANGE_BAND
+};
+
+/**
+ * @ingroup GA03
+ * @brief Registers written by a band switch, in address order. See getBandImage.
+ */
+static const uint8_t bandRegisters[BAND_REG_COUNT] = {
+    REG_BANDCFG0,       // SW_EN
+    REG_BANDCFG2,       // FM_SPACE, MW_SPACE
+    REG_BANDCFG3,       // SW_SPACE
+    REG_ADC3,           // CH_ADC_WIN<12:8>
+    REG_ADC4,           // CH_ADC_WIN<7:0>
+    REG_FMCHAN0,        // FM_HIGH_CHAN<11:8>, AM_FM
+    REG_FMCHAN1,        // FM_HIGH_CHAN<7:0>
+    REG_AMCHAN0,        // AM_HIGH_CHAN<14:8>
+    REG_AMCHAN1,        // AM_HIGH_CHAN<7:0>
+    REG_LOW_CHAN0,      // LOW_CHAN<14:8>
+    REG_LOW_CHAN1,      // LOW_CHAN<7:0>
+    REG_CHAN_NUM0,      // CHAN_NUM<11:8>
+    REG_CHAN_NUM1,      // CHAN_NUM<7:0>
+    REG_GUARD2          // CH_GUARD
+};
+
 /**
  * @ingroup GA03
  * @brief Sets the a value to a given KT09XX register
+ * @details The write does not wait for the device unless the register is listed in the timing policy table. 
  * 
  * @param reg        register number to be written (0x00 ~ 0xF7) - See #define REG_ in KT0937.h 
  * @param parameter  content you want to store 
  */
 void KT0937::setRegister(int reg, uint8_t parameter)
 {
-    Wire.begin();
-    Wire.beginTransmission(this->deviceAddress);
-    Wire.write(reg);    
-    Wire.write(parameter);
-    Wire.endTransmission();
-    delayMicroseconds(6000);
+    KT0937LockGuard transaction(&this->configLock);
+
+    // Unknown previous content is treated as "every bit changed"
+    uint8_t previous = isShadowValid(reg) ? this->shadowRegister[reg] : ~parameter;
+
+    {
+        KT0937LockGuard bus(&this->busLock);
+        beginWire();
+        this->wire->beginTransmission(this->deviceAddress);
+        this->wire->write(reg);    
+        this->wire->write(parameter);
+        this->wire->endTransmission();
+        KT0937_TRACE_ACCESS(reg, parameter, TRACE_WRITE);
+    }
+
+    updateShadow(reg, parameter);
+    if (reg == REG_FMCHAN0 && (parameter & getTriggerMask(reg)))
+    {
+        this->telemetryKick = true;     // tuned: see pollTelemetry
+        this->signalHistoryStale = true;
+    }
+    applyTimingPolicy(reg, previous, parameter);
+}
+
+/**
+ * @ingroup GA03
+ * @brief Waits for the device after a register write, according to the timing policy table
+ * @details While deferTimingPolicy is set nothing is waited for: the settling time and the readiness flag 
+ * @details are recorded in queueSettleUs / queueFlagPolicy instead (see poll and pollSetup).
+ * 
+ * @param reg        register number written
+ * @param previous   register content before the write
+ * @param parameter  register content written
+ */
+static bool isTimingPolicyTriggered(const kt09xx_timing_policy *p, int reg, uint8_t previous, uint8_t parameter)
+{
+    if (p->reg != reg)
+        return false;
+
+    uint8_t changed = (previous ^ parameter) & p->mask;
+    if (p->edge == SETTLE_ON_SET)
+        changed &= parameter;
+    return changed != 0;
+}
+
+void KT0937::applyTimingPolicy(int reg, uint8_t previous, uint8_t parameter)
+{
+    for (uint8_t i = 0; i < sizeof(timingPolicy) / sizeof(timingPolicy[0]); i++)
+    {
+        const kt09xx_timing_policy *p = &timingPolicy[i];
+        if (!isTimingPolicyTriggered(p, reg, previous, parameter))
+            continue;
+
+        if (this->deferTimingPolicy)
+        {
+            //the command queue waits without blocking. See pollTimingPolicy
+            if (p->settleUs > this->queueSettleUs)
+                this->queueSettleUs = p->settleUs;
+            if (p->flagMask && this->queueFlagPolicy == NULL)
+                this->queueFlagPolicy = p;
+            continue;
+        }
+
+        if (p->settleUs)
+            delayMicroseconds(p->settleUs);
+        if (p->flagMask && !waitRegisterFlag(p->flagReg, p->flagMask, p->flagState, p->timeoutMs, p->pollUs))
+            this->errorCode = p->errorCode;
+    }
+}
+
+/**
+ * @ingroup GA03
+ * @brief Polls a readiness flag with a bounded timeout
+ * 
+ * @param reg        register number to be polled
+ * @param mask       flag bits
+ * @param state      expected value of the flag bits
+ * @param timeoutMs  maximum time waiting (milliseconds)
+ * @param pollUs     interval between two reads (microseconds)
+ * @return true if the flag reached the expected state; false on timeout
+ */
+bool KT0937::waitRegisterFlag(int reg, uint8_t mask, uint8_t state, uint16_t timeoutMs, uint16_t pollUs)
+{
+    uint32_t start = millis();
+    while ((getRegister(reg) & mask) != state)
+    {
+        if ((millis() - start) >= timeoutMs)
+            return false;
+        if (pollUs >= 1000)
+            delay(pollUs / 1000);
+        else
+            delayMicroseconds(pollUs);
+    }
+    return true;
 }
 
 
@@ -46,21 +169,289 @@ void KT0937::setRegister(int reg, uint8_t parameter)
  */
 uint8_t KT0937::getRegister(int reg)
 {
+    // status registers are not in the shadow register map: the bus lock is enough
+    KT0937LockGuard transaction(isStatusRegister(reg) ? NULL : &this->configLock);
 
     uint8_t result;
-    Wire.begin(); 
-    Wire.beginTransmission(this->deviceAddress);
-    Wire.write(reg);
-    Wire.endTransmission(false);
-    delayMicroseconds(6000);
-    Wire.requestFrom(this->deviceAddress,1);
-    result= Wire.read();
-    Wire.endTransmission(true);
-    delayMicroseconds(6000);
+    {
+        KT0937LockGuard bus(&this->busLock);
+        beginWire();
+        this->wire->beginTransmission(this->deviceAddress);
+        this->wire->write(reg);
+        this->wire->endTransmission(false);
+        this->wire->requestFrom(this->deviceAddress,1);
+        result= this->wire->read();
+        this->wire->endTransmission(true);
+        KT0937_TRACE_ACCESS(reg, result, TRACE_READ);
+    }
+
+    updateShadow(reg, result);
 
     return result;
 }
 
+/**
+ * @ingroup GA03
+ * @brief Reads a run of consecutive KT09XX registers without refreshing the shadow register map
+ * @details Each run of up to KT0937_BURST_MAX registers is read in one I2C transaction using the device 
+ * @details address auto-increment (one register per transaction with KT0937_I2C_AUTO_INCREMENT 0).
+ * @param start  first register number (0x00 ~ 0xF7) - See #define REG_ in KT0937.h 
+ * @param buf    destination. buf[i] receives the content of register start + i
+ * @param n      number of registers to read
+ */
+void KT0937::readRegistersRaw(int start, uint8_t *buf, uint8_t n)
+{
+#if KT0937_I2C_AUTO_INCREMENT
+    const uint8_t burst = KT0937_BURST_MAX;
+#else
+    const uint8_t burst = 1;
+#endif
+    while (n)
+    {
+        uint8_t chunk = (n > burst) ? burst : n;
+
+        KT0937LockGuard bus(&this->busLock);
+        beginWire();
+        this->wire->beginTransmission(this->deviceAddress);
+        this->wire->write(start);
+        this->wire->endTransmission(false);
+        this->wire->requestFrom(this->deviceAddress, (int) chunk);
+        for (uint8_t i = 0; i < chunk; i++)
+        {
+            buf[i] = this->wire->read();
+            KT0937_TRACE_ACCESS(start + i, buf[i], TRACE_READ);
+        }
+
+        start += chunk;
+        buf += chunk;
+        n -= chunk;
+    }
+}
+
+/**
+ * @ingroup GA03
+ * @brief Reads a run of consecutive KT09XX registers
+ * @details Each run of up to KT0937_BURST_MAX registers is read in one I2C transaction using the device 
+ * @details address auto-increment, so multi-byte fields (e.g. STATUS6/STATUS7) are read coherently.
+ * @param start  first register number (0x00 ~ 0xF7) - See #define REG_ in KT0937.h 
+ * @param buf    destination. buf[i] receives the content of register start + i
+ * @param n      number of registers to read
+ */
+void KT0937::readRegisters(int start, uint8_t *buf, uint8_t n)
+{
+    KT0937LockGuard transaction(isStatusRange(start, n) ? NULL : &this->configLock);
+
+    readRegistersRaw(start, buf, n);
+    for (uint8_t i = 0; i < n; i++)
+        updateShadow(start + i, buf[i]);
+}
+
+/**
+ * @ingroup GA03
+ * @brief Writes a run of consecutive KT09XX registers
+ * @details Each run of up to KT0937_BURST_MAX registers is written in one I2C transaction using the device 
+ * @details address auto-increment. The timing policy of each register is applied after the transaction.
+ * @param start  first register number (0x00 ~ 0xF7) - See #define REG_ in KT0937.h 
+ * @param buf    source. buf[i] is written into register start + i
+ * @param n      number of registers to write
+ */
+void KT0937::writeRegisters(int start, const uint8_t *buf, uint8_t n)
+{
+    KT0937LockGuard transaction(&this->configLock);
+
+#if KT0937_I2C_AUTO_INCREMENT
+    while (n)
+    {
+        uint8_t chunk = (n > KT0937_BURST_MAX) ? KT0937_BURST_MAX : n;
+
+        {
+            KT0937LockGuard bus(&this->busLock);
+            beginWire();
+            this->wire->beginTransmission(this->deviceAddress);
+            this->wire->write(start);
+            for (uint8_t i = 0; i < chunk; i++)
+            {
+                this->wire->write(buf[i]);
+                KT0937_TRACE_ACCESS(start + i, buf[i], TRACE_WRITE);
+            }
+            this->wire->endTransmission();
+        }
+
+        for (uint8_t i = 0; i < chunk; i++)
+        {
+            uint8_t previous = isShadowValid(start + i) ? this->shadowRegister[start + i] : ~buf[i];
+            updateShadow(start + i, buf[i]);
+            if (start + i == REG_FMCHAN0 && (buf[i] & getTriggerMask(REG_FMCHAN0)))
+            {
+                this->telemetryKick = true;     // tuned: see pollTelemetry
+                this->signalHistoryStale = true;
+            }
+            applyTimingPolicy(start + i, previous, buf[i]);
+        }
+
+        start += chunk;
+        buf += chunk;
+        n -= chunk;
+    }
+#else
+    for (uint8_t i = 0; i < n; i++)
+        setRegister(start + i, buf[i]);
+#endif
+}
+
+/**
+ * @ingroup GA03
+ * @brief Gets a run of consecutive registers from the shadow register map 
+ * @details If any register of the run is not in the shadow register map, the whole run is read with readRegisters.
+ * @param start  first register number (0x00 ~ 0xF7)
+ * @param buf    destination. buf[i] receives the content of register start + i
+ * @param n      number of registers
+ */
+void KT0937::getCachedRegisters(int start, uint8_t *buf, uint8_t n)
+{
+    KT0937LockGuard transaction(&this->configLock);
+
+    for (uint8_t i = 0; i < n; i++)
+    {
+        if (!isShadowValid(start + i))
+        {
+            readRegisters(start, buf, n);
+            return;
+        }
+    }
+    memcpy(buf, &this->shadowRegister[start], n);
+}
+
+/**
+ * @ingroup GA03
+ * @brief Checks if the shadow register map holds the content of a given register
+ * @param reg  register number (0x00 ~ 0xF7)
+ * @return true if getCachedRegister can answer without an I2C transaction
+ */
+bool KT0937::isShadowValid(int reg)
+{
+    return !isStatusRegister(reg) && (this->shadowValid[reg >> 3] & (1 << (reg & 7)));
+}
+
+/**
+ * @ingroup GA03
+ * @brief Checks if the device already holds a given value in a given register (according to the shadow register map)
+ * @param reg    register number (0x00 ~ 0xF7)
+ * @param value  register content
+ * @return true if writing value into reg can be skipped
+ */
+bool KT0937::isShadowEqual(int reg, uint8_t value)
+{
+    return isShadowValid(reg) && this->shadowRegister[reg] == value;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Stores the content of a given register in the shadow register map
+ * @details Status registers are ignored. Self-clearing trigger bits (CHANGE_BAND, CH_ADC_START) are not kept.
+ * @param reg    register number (0x00 ~ 0xF7)
+ * @param value  register content read from or written to the device
+ */
+void KT0937::updateShadow(int reg, uint8_t value)
+{
+    if (isStatusRegister(reg))
+        return;
+
+    this->shadowRegister[reg] = value & ~getTriggerMask(reg);
+    this->shadowValid[reg >> 3] |= (1 << (reg & 7));
+}
+
+/**
+ * @ingroup GA03
+ * @brief Gets a given KT09XX register content from the shadow register map 
+ * @details The KT0937 class keeps a write-through copy of the config registers. Every setRegister and
+ * @details getRegister call refreshes it, so a read-modify-write of a config register costs one I2C write.
+ * @details Status registers (see isStatusRegister) and registers never accessed before are read from the device.
+ * @param reg  register number to be read (0x00 ~ 0xF7) - See #define REG_ in KT0937.h 
+ * @return the register content
+ */
+uint8_t KT0937::getCachedRegister(int reg)
+{
+    KT0937LockGuard transaction(&this->configLock);
+
+    if (!isShadowValid(reg))
+        return getRegister(reg);
+
+    return this->shadowRegister[reg];
+}
+
+/**
+ * @ingroup GA03
+ * @brief Discards the shadow register map 
+ * @details Call it when the device content may have changed behind the library (power cycle, reset, other I2C master).
+ * @details The next getCachedRegister call of each register will read it from the device again.
+ */
+void KT0937::invalidateRegisterCache()
+{
+    KT0937LockGuard transaction(&this->configLock);
+
+    memset(this->shadowValid, 0, sizeof(this->shadowValid));
+}
+
+/**
+ * @ingroup GA03
+ * @brief Checks if a given register can change by itself (status and flag registers)
+ * @details These registers are never served from the shadow register map.
+ * @param reg  register number (0x00 ~ 0xF7)
+ * @return true if the register must always be read from the device
+ */
+bool KT0937::isStatusRegister(int reg)
+{
+    if (reg < 0 || reg >= KT0937_REG_COUNT)
+        return true;
+
+    switch (reg)
+    {
+    case REG_G38KCFG0:      // POWERON_FINISH
+    case REG_G38KCFG1:      // ST_DEMOD
+    case REG_STATUS10:      // AFC_AAF
+        return true;
+    }
+
+    // STATUS0 ~ STATUS8, AFC_STATUS0/1, AMSTATUS0 ~ AMSTATUS3
+    return (reg >= REG_STATUS0 && reg <= REG_AMSTATUS3);
+}
+
+/**
+ * @ingroup GA03
+ * @brief Checks if a run of consecutive registers holds status registers only
+ * @details Reading such a run does not touch the shadow register map, so it only needs the bus lock.
+ * @param start  first register number (0x00 ~ 0xF7)
+ * @param n      number of registers
+ * @return true if every register of the run is a status register (see isStatusRegister)
+ */
+bool KT0937::isStatusRange(int start, uint8_t n)
+{
+    for (uint8_t i = 0; i < n; i++)
+        if (!isStatusRegister(start + i))
+            return false;
+    return true;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Gets the self-clearing bits of a given register
+ * @details CHANGE_BAND and CH_ADC_START are cleared by the device after they are set to 1. 
+ * @param reg  register number (0x00 ~ 0xF7)
+ * @return bit mask of the trigger bits
+ */
+uint8_t KT0937::getTriggerMask(int reg)
+{
+    switch (reg)
+    {
+    case REG_FMCHAN0:       // CHANGE_BAND
+        return 0x80;
+    case REG_ADC0:          // CH_ADC_START
+        return 0x04;
+    }
+    return 0x00;
+}
+
 /**
  * @ingroup GA03
  * @brief Gets the Device Id 
@@ -68,6 +459,8 @@ uint8_t KT0937::getRegister(int reg)
  */
 uint16_t KT0937::getDeviceId()
 {
+    KT0937LockGuard transaction(&this->configLock);
+
     uint8_t id_0 ;
     //uint8_t id_1 ;
     id_0 = getRegister(REG_DEVICEID0);
@@ -85,9 +478,63 @@ uint16_t KT0937::getDeviceId()
  */
 void KT0937::setI2CBusAddress(int deviceAddress)
 {
+    KT0937LockGuard bus(&this->busLock);
     this->deviceAddress = deviceAddress;
 }
 
+/**
+ * @ingroup GA03
+ * @brief Sets the I2C controller and the bus clock used to talk to the KT0937
+ * @details Call it before setup(). begin() and setClock() are called once, at the next register access. 
+ * @details E.g. the second ESP32 controller in Fast-mode: setI2CBus(Wire1, I2C_CLOCK_400KHZ).
+ * 
+ * @param wire   I2C controller (Wire, Wire1...)
+ * @param clock  bus clock (Hz). I2C_CLOCK_100KHZ, I2C_CLOCK_400KHZ or I2C_CLOCK_1MHZ
+ */
+void KT0937::setI2CBus(TwoWire &wire, uint32_t clock)
+{
+    KT0937LockGuard bus(&this->busLock);
+    this->wire = &wire;
+    this->i2cClock = clock;
+    this->wireStarted = false;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Starts an atomic transaction: no other task can change the KT0937 configuration until endTransaction
+ * @details Every API call is already a transaction of its own. Use it to group several calls, e.g. 
+ * @details enableSWAmp(TURN_ON) and setSWBand(). Calls can be nested; each one needs its endTransaction. 
+ * @details Status reads (getRSSI, getSNR, getCurrentChannel, readStatus) of other tasks are not blocked.
+ * @details Does nothing with KT0937_LOCK_NONE.
+ */
+void KT0937::beginTransaction()
+{
+    this->configLock.lock();
+}
+
+/**
+ * @ingroup GA03
+ * @brief Ends a transaction started with beginTransaction
+ */
+void KT0937::endTransaction()
+{
+    this->configLock.unlock();
+}
+
+/**
+ * @ingroup GA03
+ * @brief Initialises the I2C controller once (begin and setClock)
+ */
+void KT0937::beginWire()
+{
+    if (this->wireStarted)
+        return;
+
+    this->wire->begin();
+    this->wire->setClock(this->i2cClock);
+    this->wireStarted = true;
+}
+
 /**
  * @ingroup GA03
  * @brief get errorCode 
@@ -110,6 +557,8 @@ uint8_t KT0937::getErrorCode()
  */
 void KT0937::enableSWAmp(uint8_t on_off)
 {
+    KT0937LockGuard transaction(&this->configLock);
+
     if (this->swOnPin < 0)
         return;
         
@@ -117,164 +566,295 @@ void KT0937::enableSWAmp(uint8_t on_off)
     digitalWrite(this->swOnPin, on_off);
 }
 
+/**
+ * @ingroup GA03
+ * @brief Clock profiles, indexed by OSCILLATOR_32KHZ ~ OSCILLATOR_38KHz. Computed at compile time.
+ */
+static const kt09xx_clock_profile clockProfile[] = {
+    makeClockProfile(32768, 0),         // OSCILLATOR_32KHZ
+    makeClockProfile(6500000, 1),       // OSCILLATOR_6_5MHZ
+    makeClockProfile(7600000, 1),       // OSCILLATOR_7_6MHZ
+    makeClockProfile(12000000, 1),      // OSCILLATOR_12MHZ
+    makeClockProfile(13000000, 1),      // OSCILLATOR_13MHZ
+    makeClockProfile(15200000, 1),      // OSCILLATOR_15_2MHZ
+    makeClockProfile(19200000, 1),      // OSCILLATOR_19_2MHZ
+    makeClockProfile(24000000, 1),      // OSCILLATOR_24MHZ
+    makeClockProfile(26000000, 1),      // OSCILLATOR_26MHZ
+    makeClockProfile(38000, 0)          // OSCILLATOR_38KHz
+};
+
+/**
+ * @ingroup GA03
+ * @brief Sets the reference clock used by setSystemClock()
+ * @details Call it before setup(). MHz references (OSCILLATOR_6_5MHZ ~ OSCILLATOR_26MHZ) are always 
+ * @details configured as external reference clock (RCLK_EN = 1). E.g. a 26MHz TCXO: 
+ * @details setReferenceClockType(OSCILLATOR_26MHZ, REF_CLOCK_ENABLE).
+ * 
+ * @param type             OSCILLATOR_32KHZ ~ OSCILLATOR_38KHz
+ * @param refClockEnabled  REF_CLOCK_DISABLE (crystal) or REF_CLOCK_ENABLE (external reference clock)
+ */
+void KT0937::setReferenceClockType(uint8_t type, uint8_t refClockEnabled)
+{
+    KT0937LockGuard transaction(&this->configLock);
+
+    if (type >= sizeof(clockProfile) / sizeof(clockProfile[0]))
+        return;
+
+    this->currentRefClockType = type;
+    this->currentRefClockEnabled = refClockEnabled | clockProfile[type].refClockRequired;
+}
+
 /**
  * @ingroup GA03
  * @brief set the KT0937 System Clock .
+ * @details Writes DIVIDERP, DIVIDERN, FPFD and RCLK_EN of the current clock profile (see setReferenceClockType) 
+ * @details in one burst (PLLCFG0 ~ XTALCFG, 0x04 ~ 0x0D), then sets SYS_CFGOK.
  *     
- * @see setup
- * 
- * @param on_off  1 = enable; 0 = disable
+ * @see setup, setReferenceClockType
  */
 void KT0937::setSystemClock()
 {
-    //set DIVIDERP<10:0>
+    KT0937LockGuard transaction(&this->configLock);
+
+    const kt09xx_clock_profile *profile = &clockProfile[this->currentRefClockType];
+    uint8_t clk[REG_XTALCFG - REG_PLLCFG0 + 1];
+    getCachedRegisters(REG_PLLCFG0, clk, sizeof(clk));
+
+    //DIVIDERP<10:0>. SYS_CFGOK stays 0 until the whole clock is configured
     kt09xx_pllcfg_0 reg0;
-    reg0.raw = getRegister(REG_PLLCFG0); //get the current value of REG
-    reg0.refined.DIVIDERP_10_8 = 0; //set dividerp <10:8> to 0
-    setRegister(REG_PLLCFG0, reg0.raw); // write back to chip kt0937
+    reg0.raw = clk[0];
+    reg0.refined.DIVIDERP_10_8 = (profile->dividerP >> 8) & 0x07;
+    reg0.refined.SYS_CFGOK = 0;
+    clk[0] = reg0.raw;
 
-    //set DIVIDERP<7:0>
     kt09xx_pllcfg_1 reg1;
-    reg1.raw = getRegister(REG_PLLCFG1); //get the current value of REG
-    reg1.refined.DIVIDERP_7_0 = 1; //set dividerp <7:0> to 1
-    setRegister(REG_PLLCFG1, reg1.raw); // write back to chip kt0937
+    reg1.raw = clk[1];
+    reg1.refined.DIVIDERP_7_0 = profile->dividerP & 0xFF;
+    clk[1] = reg1.raw;
 
-    //set DIVIDERN<10:8>
+    //DIVIDERN<10:0>
     kt09xx_pllcfg_2 reg2;
-    reg2.raw = getRegister(REG_PLLCFG2); //get the current value of REG
-    reg2.refined.DIVIDERN_10_8 = 2; //set dividerB <10:8> to 2
-    setRegister(REG_PLLCFG2, reg2.raw); // write back to chip kt0937
+    reg2.raw = clk[2];
+    reg2.refined.DIVIDERN_10_8 = (profile->dividerN >> 8) & 0x07;
+    clk[2] = reg2.raw;
 
-    //set DIVIDERN<7:0>
     kt09xx_pllcfg_3 reg3;
-    reg3.raw = getRegister(REG_PLLCFG3); //get the current value of REG
-    reg3.refined.DIVIDERN_7_0 = 0x9C; //set dividern <7:0> to 0X9C
-    setRegister(REG_PLLCFG3, reg3.raw); // write back to chip kt0937
+    reg3.raw = clk[3];
+    reg3.refined.DIVIDERN_7_0 = profile->dividerN & 0xFF;
+    clk[3] = reg3.raw;
 
-    //set FPFD <19:16> to 8
+    //FPFD<19:0>
     kt09xx_sysclk_cfg_0 reg4;
-    reg4.raw = getRegister(REG_SYSCLK_CFG0); //get the current value of REG
-    reg4.refined.FPFD_19_16 = 8; //set 
-    setRegister(REG_SYSCLK_CFG0, reg4.raw); // write back to chip kt0937
+    reg4.raw = clk[4];
+    reg4.refined.FPFD_19_16 = (profile->fpfd >> 16) & 0x0F;
+    clk[4] = reg4.raw;
 
-    //set FPFD <15:8> to 0
     kt09xx_sysclk_cfg_1 reg5;
-    reg5.raw = getRegister(REG_SYSCLK_CFG1); //get the current value of REG
-    reg5.refined.FPFD_15_8 = 0; //set 
-    setRegister(REG_SYSCLK_CFG1, reg5.raw); // write back to chip kt0937
+    reg5.raw = clk[5];
+    reg5.refined.FPFD_15_8 = (profile->fpfd >> 8) & 0xFF;
+    clk[5] = reg5.raw;
 
-    //set FPFD <7:0> to 0
     kt09xx_sysclk_cfg_2 reg6;
-    reg6.raw = getRegister(REG_SYSCLK_CFG2); //get the current value of REG
-    reg6.refined.FPFD_7_0 = 0; //set 
-    setRegister(REG_SYSCLK_CFG2, reg6.raw); // write back to chip kt0937
+    reg6.raw = clk[6];
+    reg6.refined.FPFD_7_0 = profile->fpfd & 0xFF;
+    clk[6] = reg6.raw;
 
-    //setting xtalcfg;
+    //RCLK_EN: 0 = crystal; 1 = external Clock
     kt09xx_xtalcfg reg7;
-    reg7.raw = getRegister(REG_XTALCFG); //get the current value of REG
-    reg7.refined.RCLK_EN = 0; //set the bit to 0: crystal; 1: external Clock
-    setRegister(REG_XTALCFG, reg7.raw); // write back to chip kt0937
+    reg7.raw = clk[REG_XTALCFG - REG_PLLCFG0];
+    reg7.refined.RCLK_EN = this->currentRefClockEnabled;
+    clk[REG_XTALCFG - REG_PLLCFG0] = reg7.raw;
 
- 
- //set SYS_CFGOK<7>
-    kt09xx_pllcfg_0 reg8;
-    reg8.raw = getRegister(REG_PLLCFG0); //get the current value of REG
-    reg8.refined.SYS_CFGOK = 1; //set SYS_CFGOK to 1
-    setRegister(REG_PLLCFG0, reg8.raw); // write back to chip kt0937    
+    writeRegisters(REG_PLLCFG0, clk, sizeof(clk));
+
+    //set SYS_CFGOK<7>. The timing policy waits for POWERON_FINISH
+    reg0.refined.SYS_CFGOK = 1;
+    setRegister(REG_PLLCFG0, reg0.raw);
 }
 
 /**
  * @ingroup GA03
- * @brief nitialize KT0937.
+ * @brief Initialize KT0937.
+ * @details Blocking version of beginSetup() / pollSetup(). Returns after POWERON_FINISH or after POWERON_TIMEOUT_MS.
  *     
- * @see setup
+ * @see beginSetup, pollSetup
  * 
- * @param 
+ * @return ERR_OK or ERR_CLK (the clock did not lock)
  */
-
-void KT0937::setup()
+uint8_t KT0937::setup()
 {
-//standby
-enableStandbyMode();
-
-//wake up
-wakeUp();
-
-//set DEPOP_TC<2:0> to 3
- kt09xx_anacfg_0 reg0;
- reg0.raw = getRegister(REG_ANACFG0);
- reg0.refined.DEPOP_TC = 3;
- setRegister(REG_ANACFG0,reg0.raw);
-
- //set AUDV_DCLVL<2:0> 2
- 
- kt09xx_anacfg_0 reg1;
- reg1.raw = getRegister(REG_ANACFG0);
- reg1.refined.AUDV_DCLVL= 2;
- setRegister(REG_ANACFG0,reg1.raw);
-
- setSystemClock();
-
-//check power on
-kt09xx_g38kcfg_0 reg2;
+    KT0937LockGuard transaction(&this->configLock);
 
-while(1)
-{
-    reg2.raw = getRegister(REG_G38KCFG0);
-    if(reg2.refined.POWERON_FINISH == 1)
+    beginSetup();
+    while (!pollSetup())
     {
-        break;
-    }else{
-        this->errorCode = ERR_CLK ;
+        //only SETUP_POWERON reads the device; the other steps just wait STDBY_SETTLE_US
+        if (this->setupState == SETUP_POWERON)
+            delay(POWERON_POLL_MS);
+        else
+            delayMicroseconds(STDBY_SETTLE_US);
     }
-delay(5);
+    return this->errorCode;
 }
 
-/*
-//set FLT_SEL<2:0> to 1
-kt09xx_amdsp_0 reg3;
-reg3.raw = getRegister(REG_AMDSP0);
-reg3.refined.FLT_SEL = 0;
-setRegister(REG_AMDSP0, reg3.raw);
-
-//setFM_AFC
-disableFMAFC(1);
-//setAM_AFC
-disableMWAFC(1);
-//setSW_AFC
-disableSWAFC(1);
-//setFM softmute
-disableFMSoftMute(1);
-//setAM softmute
-disableMWSoftMute(1);
-
-
-*/
-//set ANT_CALI_SWITCH_BAND to 1
+/**
+ * @ingroup GA03
+ * @brief Initialize KT0937 and sets the pin that controls the SW RF amplifier
+ * 
+ * @param sw_on_pin  SW amplifier control pin. See enableSWAmp
+ * @return ERR_OK or ERR_CLK (the clock did not lock)
+ */
+uint8_t KT0937::setup(uint8_t sw_on_pin)
+{
+    KT0937LockGuard transaction(&this->configLock);
 
-kt09xx_dspcfg_5 reg4;
-reg4.raw = getRegister(REG_DSPCFG5);
-reg4.refined.ANT_CALI_SWITCH_BAND = 1;
-reg4.refined.AM_SUP_ENHANCE = 1; //AM_SUP_ENHANCE 1 
-reg4.refined.AM_SEL_ENHANCE = 1; //AM_SEL_ENHANCE 1
-setRegister(REG_DSPCFG5, reg4.raw);
+    this->swOnPin = sw_on_pin;
+    return setup();
+}
 
-//set INT mode
+/**
+ * @ingroup GA03
+ * @brief Starts the KT0937 initialization without blocking
+ * @details Sets the device to standby. Call pollSetup() until it returns true; the MCU is free to do 
+ * @details other work (display, peripherals...) between the calls while the device wakes up and the PLL locks.
+ * 
+ * @see pollSetup, setup
+ */
+void KT0937::beginSetup()
+{
+    KT0937LockGuard transaction(&this->configLock);
 
+    //the device may have been power cycled, forget the shadow register map
+    invalidateRegisterCache();
+    this->errorCode = ERR_OK;
 
-//enable DialMode
-enableDialMode(); 
+    //standby. STDBY settling is handled by pollSetup
+    this->deferTimingPolicy = true;
+    enableStandbyMode();
+    this->deferTimingPolicy = false;
 
+    this->setupState = SETUP_STANDBY;
+    this->setupTimer = micros();
 }
 
-void KT0937::setup(uint8_t sw_on_pin)
+/**
+ * @ingroup GA03
+ * @brief Runs the next step of the KT0937 initialization started by beginSetup()
+ * @details Never waits: a step whose settling time (STDBY_SETTLE_US) has not elapsed yet just returns false. 
+ * @details The steps are: wake up, audio/clock configuration (DEPOP_TC and AUDV_DCLVL in one write, clock 
+ * @details registers in one burst), wait POWERON_FINISH (up to POWERON_TIMEOUT_MS) and the DSP settings.
+ * 
+ * @see beginSetup, getErrorCode
+ * 
+ * @return true when the initialization is finished (getErrorCode() returns ERR_OK or ERR_CLK); false while it is in progress
+ */
+bool KT0937::pollSetup()
 {
-    this->swOnPin = sw_on_pin;
+    KT0937LockGuard transaction(&this->configLock);
+
+    uint32_t elapsedUs = micros() - this->setupTimer;
 
-    //debug
-    this->errorCode = ERR_SW_PIN ;
-    setup(); 
-       
+    switch (this->setupState)
+    {
+    case SETUP_STANDBY:
+    {
+        if (elapsedUs < STDBY_SETTLE_US)
+            return false;
+
+        //wake up: set STDBY to 0. STBYLDO_PD is set after STDBY_SETTLE_US
+        kt09xx_rxcfg_0 rxcfg0;
+        rxcfg0.raw = getCachedRegister(REG_RXCFG0);
+        rxcfg0.refined.STDBY = 0;
+        this->deferTimingPolicy = true;
+        setRegister(REG_RXCFG0, rxcfg0.raw);
+        this->deferTimingPolicy = false;
+
+        this->setupState = SETUP_WAKEUP;
+        this->setupTimer = micros();
+        return false;
+    }
+    case SETUP_WAKEUP:
+    {
+        if (elapsedUs < STDBY_SETTLE_US)
+            return false;
+
+        //set STBYLDO_PD to 1
+        kt09xx_adc_5 adc5;
+        adc5.raw = getCachedRegister(REG_ADC5);
+        adc5.refined.STBYLDO_PD = 1;
+        setRegister(REG_ADC5, adc5.raw);
+
+        //set DEPOP_TC<2:0> to 3 and AUDV_DCLVL<2:0> to 2
+        kt09xx_anacfg_0 anacfg0;
+        anacfg0.raw = getCachedRegister(REG_ANACFG0);
+        anacfg0.refined.DEPOP_TC = 3;
+        anacfg0.refined.AUDV_DCLVL = 2;
+        setRegister(REG_ANACFG0, anacfg0.raw);
+
+        //POWERON_FINISH is polled by the next steps
+        this->deferTimingPolicy = true;
+        setSystemClock();
+        this->deferTimingPolicy = false;
+
+        this->setupState = SETUP_POWERON;
+        this->setupTimer = micros();
+        return false;
+    }
+    case SETUP_POWERON:
+    {
+        //check power on
+        kt09xx_g38kcfg_0 g38kcfg0;
+        g38kcfg0.raw = getRegister(REG_G38KCFG0);
+        if (g38kcfg0.refined.POWERON_FINISH == 0)
+        {
+            if (elapsedUs < (uint32_t) POWERON_TIMEOUT_MS * 1000)
+                return false;
+            this->errorCode = ERR_CLK;
+            this->setupState = SETUP_DONE;
+            return true;
+        }
+
+        /*
+        //set FLT_SEL<2:0> to 1
+        kt09xx_amdsp_0 reg3;
+        reg3.raw = getCachedRegister(REG_AMDSP0);
+        reg3.refined.FLT_SEL = 0;
+        setRegister(REG_AMDSP0, reg3.raw);
+
+        //setFM_AFC
+        disableFMAFC(1);
+        //setAM_AFC
+        disableMWAFC(1);
+        //setSW_AFC
+        disableSWAFC(1);
+        //setFM softmute
+        disableFMSoftMute(1);
+        //setAM softmute
+        disableMWSoftMute(1);
+
+
+        */
+
+        //set ANT_CALI_SWITCH_BAND to 1
+        kt09xx_dspcfg_5 dspcfg5;
+        dspcfg5.raw = getCachedRegister(REG_DSPCFG5);
+        dspcfg5.refined.ANT_CALI_SWITCH_BAND = 1;
+        dspcfg5.refined.AM_SUP_ENHANCE = 1; //AM_SUP_ENHANCE 1 
+        dspcfg5.refined.AM_SEL_ENHANCE = 1; //AM_SEL_ENHANCE 1
+        setRegister(REG_DSPCFG5, dspcfg5.raw);
+
+        //enable DialMode
+        enableDialMode(); 
+
+        this->setupState = SETUP_DONE;
+        return true;
+    }
+    case SETUP_DONE:
+        return true;
+    default:
+        //beginSetup() not called
+        return false;
+    }
 }
 
 /**
@@ -289,23 +869,24 @@ void KT0937::setup(uint8_t sw_on_pin)
 
 void KT0937::enableStandbyMode()
 {
+    KT0937LockGuard transaction(&this->configLock);
+
     //set STBYLDO_CALI_EN to 1
     kt09xx_pvtcali_0 reg0;
-    reg0.raw = getRegister(REG_PVTCALI0);
+    reg0.raw = getCachedRegister(REG_PVTCALI0);
     reg0.refined.STBYLDO_CALI_EN = 1;
     setRegister(REG_PVTCALI0, reg0.raw);
-    this->errorCode = getRegister(REG_PVTCALI0);
     
 
     //set STBYLDO_PD to 0
     kt09xx_adc_5 reg1;
-    reg1.raw = getRegister(REG_ADC5);
+    reg1.raw = getCachedRegister(REG_ADC5);
     reg1.refined.STBYLDO_PD = 0;
     setRegister(REG_ADC5, reg1.raw);
 
      //set STDBY to 1
     kt09xx_rxcfg_0 reg2;
-    reg2.raw = getRegister(REG_RXCFG0);
+    reg2.raw = getCachedRegister(REG_RXCFG0);
     reg2.refined.STDBY = 1;
     setRegister(REG_RXCFG0, reg2.raw);
 }
@@ -320,48 +901,218 @@ void KT0937::enableStandbyMode()
  */
 void KT0937::wakeUp()
 {
+    KT0937LockGuard transaction(&this->configLock);
+
    //set STDBY to 0
     kt09xx_rxcfg_0 reg2;
-    reg2.raw = getRegister(REG_RXCFG0);
+    reg2.raw = getCachedRegister(REG_RXCFG0);
     reg2.refined.STDBY = 0;
-    setRegister(REG_RXCFG0, reg2.raw);
-    delay(1);
+    setRegister(REG_RXCFG0, reg2.raw);   // waits STDBY_SETTLE_US
     //set STBYLDO_PD to 1
     kt09xx_adc_5 reg1;
-    reg1.raw = getRegister(REG_ADC5);
+    reg1.raw = getCachedRegister(REG_ADC5);
     reg1.refined.STBYLDO_PD = 1;
     setRegister(REG_ADC5, reg1.raw);
 }
 
-void KT0937::resetDSP()
+/**
+ * @ingroup GA03
+ * @brief Key registers of suspend / resume: clock (PLLCFG0 ~ XTALCFG), RXCFG0 ~ RXCFG1 (volume) and the 
+ * @brief channel registers (FMCHAN0 ~ AMCHAN1, LOW_CHAN0 ~ CHAN_NUM1). {first register, count}
+ */
+static const uint8_t retainedRanges[][2] = {
+    { REG_PLLCFG0,      REG_RXCFG1 - REG_PLLCFG0 + 1 },
+    { REG_FMCHAN0,      REG_AMCHAN1 - REG_FMCHAN0 + 1 },
+    { REG_LOW_CHAN0,    REG_CHAN_NUM1 - REG_LOW_CHAN0 + 1 }
+};
+
+/**
+ * @ingroup GA03
+ * @brief Reads the key registers (retainedRanges) from the device or from the shadow register map
+ * @param key         receives RETAINED_KEY_COUNT bytes, in the retainedRanges order
+ * @param fromDevice  true = I2C reads that leave the shadow register map untouched; false = shadow register map
+ */
+void KT0937::getRetainedKey(uint8_t *key, bool fromDevice)
 {
-    //set DSP_RST to 1
-    kt09xx_rxcfg_0 reg;
-    reg.raw = getRegister(REG_RXCFG0);
-    reg.refined.DSP_RST = 1;
-    setRegister(REG_RXCFG0, reg.raw);
+    for (uint8_t i = 0; i < sizeof(retainedRanges) / sizeof(retainedRanges[0]); i++)
+    {
+        if (fromDevice)
+            readRegistersRaw(retainedRanges[i][0], key, retainedRanges[i][1]);
+        else
+            getCachedRegisters(retainedRanges[i][0], key, retainedRanges[i][1]);
+        key += retainedRanges[i][1];
+    }
 }
 
-void KT0937::enableSW(uint8_t enable_sw)
+/**
+ * @ingroup GA03
+ * @brief Fletcher-16 checksum of the key registers. STDBY and CHANGE_BAND are left out.
+ */
+static uint16_t getRetainedChecksum(const uint8_t *key)
 {
-    //enable short wave
-    kt09xx_bandcfg_0 reg;
-    reg.raw = getRegister(REG_BANDCFG0);
-    reg.refined.SW_EN = enable_sw;
-    setRegister(REG_BANDCFG0, reg.raw);
+    uint16_t sum1 = 0;
+    uint16_t sum2 = 0;
+    uint8_t k = 0;
 
+    for (uint8_t i = 0; i < sizeof(retainedRanges) / sizeof(retainedRanges[0]); i++)
+    {
+        for (uint8_t j = 0; j < retainedRanges[i][1]; j++, k++)
+        {
+            uint8_t reg = retainedRanges[i][0] + j;
+            uint8_t value = key[k];
+            if (reg == REG_RXCFG0)
+                value &= ~0x20;     // STDBY
+            else if (reg == REG_FMCHAN0)
+                value &= ~0x80;     // CHANGE_BAND
+            sum1 = (sum1 + value) % 255;
+            sum2 = (sum2 + sum1) % 255;
+        }
+    }
+    return (sum2 << 8) | sum1;
 }
 
 /**
  * @ingroup GA03
- * @brief set the volumn of KT0937
- *     
- * @see setup
+ * @brief Puts the device in standby and keeps what is needed for a fast resume
+ * @details The shadow register map (kept in MCU RAM) is the retained config image: suspend makes sure it 
+ * @details holds the key registers (clock, volume, channel) and records their checksum. Then STDBY is set. 
+ * @details Run the command queue (poll) to its end before calling suspend.
+ * 
+ * @see resume
+ */
+void KT0937::suspend()
+{
+    KT0937LockGuard transaction(&this->configLock);
+
+    uint8_t key[RETAINED_KEY_COUNT];
+
+    getRetainedKey(key, false);
+    this->suspendChecksum = getRetainedChecksum(key);
+    enableStandbyMode();
+    this->suspended = true;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Leaves the standby entered with suspend()
+ * @details Warm path: the key registers are read back in 3 bursts. If their checksum matches the one of suspend, 
+ * @details the config was retained: the device is woken up and, if the PLL is still configured (SYS_CFGOK) 
+ * @details and locked (POWERON_FINISH), nothing else is done; setSystemClock and the POWERON_FINISH poll are skipped. 
+ * @details Cold path (the device lost its registers, e.g. power cycle): the clock is configured again if needed 
+ * @details and every config register of the shadow register map that differs from the device is written 
+ * @details back (one burst per run), followed by CHANGE_BAND if a band register was lost.
+ * @details Without a previous suspend() this is setup().
+ * 
+ * @return ERR_OK or ERR_CLK (the clock did not lock)
+ */
+uint8_t KT0937::resume()
+{
+    KT0937LockGuard transaction(&this->configLock);
+
+    uint8_t key[RETAINED_KEY_COUNT];
+
+    if (!this->suspended)
+        return setup();
+    this->suspended = false;
+    this->errorCode = ERR_OK;
+
+    getRetainedKey(key, true);
+    bool retained = getRetainedChecksum(key) == this->suspendChecksum;
+
+    wakeUp();
+
+    kt09xx_pllcfg_0 pllcfg0;
+    pllcfg0.raw = key[0];
+    if (!retained || !pllcfg0.refined.SYS_CFGOK)
+    {
+        if (!pllcfg0.refined.SYS_CFGOK || memcmp(key, &this->shadowRegister[REG_PLLCFG0], REG_XTALCFG - REG_PLLCFG0 + 1) != 0)
+            setSystemClock();                   // the timing policy waits for POWERON_FINISH
+        restoreRegisters();
+        return this->errorCode;
+    }
+
+    kt09xx_g38kcfg_0 g38kcfg0;
+    g38kcfg0.raw = getRegister(REG_G38KCFG0);
+    if (!g38kcfg0.refined.POWERON_FINISH && !waitRegisterFlag(REG_G38KCFG0, 0x04, 0x04, POWERON_TIMEOUT_MS, POWERON_POLL_MS * 1000))
+        this->errorCode = ERR_CLK;
+    return this->errorCode;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Writes back the config registers the device lost (cold resume)
+ * @details RXCFG0 ~ 0xF7 are read in bursts without touching the shadow register map; every valid shadow register 
+ * @details that differs is written, one burst per run. CHANGE_BAND is set at the end if a band register was written.
+ */
+void KT0937::restoreRegisters()
+{
+    uint8_t chip[KT0937_BURST_MAX];
+    bool bandLost = false;
+
+    for (uint16_t start = REG_RXCFG0; start < KT0937_REG_COUNT; start += KT0937_BURST_MAX)
+    {
+        uint8_t n = (KT0937_REG_COUNT - start > KT0937_BURST_MAX) ? KT0937_BURST_MAX : KT0937_REG_COUNT - start;
+        readRegistersRaw(start, chip, n);
+
+        uint8_t i = 0;
+        while (i < n)
+        {
+            uint8_t reg = start + i;
+            if (!isShadowValid(reg) || (chip[i] & ~getTriggerMask(reg)) == this->shadowRegister[reg])
+            {
+                i++;
+                continue;
+            }
+
+            uint8_t run = 1;
+            while (i + run < n && isShadowValid(reg + run) && (chip[i + run] & ~getTriggerMask(reg + run)) != this->shadowRegister[reg + run])
+                run++;
+            for (uint8_t j = 0; j < BAND_REG_COUNT; j++)
+                if (bandRegisters[j] >= reg && bandRegisters[j] < reg + run)
+                    bandLost = true;
+            writeRegisters(reg, &this->shadowRegister[reg], run);
+            i += run;
+        }
+    }
+
+    if (bandLost)
+        setRegister(REG_FMCHAN0, this->shadowRegister[REG_FMCHAN0] | 0x80);     // CHANGE_BAND
+}
+
+void KT0937::resetDSP()
+{
+    KT0937LockGuard transaction(&this->configLock);
+
+    //set DSP_RST to 1
+    kt09xx_rxcfg_0 reg;
+    reg.raw = getCachedRegister(REG_RXCFG0);
+    reg.refined.DSP_RST = 1;
+    setRegister(REG_RXCFG0, reg.raw);
+}
+
+void KT0937::enableSW(uint8_t enable_sw)
+{
+    KT0937LockGuard transaction(&this->configLock);
+
+    //enable short wave
+    kt09xx_bandcfg_0 reg;
+    reg.raw = getCachedRegister(REG_BANDCFG0);
+    reg.refined.SW_EN = enable_sw;
+    setRegister(REG_BANDCFG0, reg.raw);
+
+}
+
+/**
+ * @ingroup GA03
+ * @brief set the volumn of KT0937
+ *     
+ * @see setup
  * 
  * @param 
  */
 void KT0937::setVolume(int8_t volume)
 {
+    KT0937LockGuard transaction(&this->configLock);
     
     if(volume > 31) {
         volume = 31; // max 31 , min 0
@@ -370,16 +1121,43 @@ void KT0937::setVolume(int8_t volume)
     }
     
     this->currentVolume = volume;    
-    //set VOLUMN<4:0> to volumn
+    //set VOLUMN<4:0> to volumn (VOLUME = 0 while muted, see setMute)
     
     kt09xx_rxcfg_1 reg;
-    reg.raw = getRegister(REG_RXCFG1);
-    reg.refined.VOLUME = volume;
+    reg.raw = getCachedRegister(REG_RXCFG1);
+    reg.refined.VOLUME = this->muted ? 0 : volume;
     setRegister(REG_RXCFG1,reg.raw);
 }
 
+/**
+ * @ingroup GA03
+ * @brief Mutes or unmutes the audio output
+ * @details Muting writes VOLUME = 0 and keeps the volume set with setVolume, which is written back on unmute. 
+ * @details setVolume calls while muted only change the volume restored later.
+ * 
+ * @param mute  true = mute
+ */
+void KT0937::setMute(bool mute)
+{
+    KT0937LockGuard transaction(&this->configLock);
+
+    this->muted = mute;
+    setVolume(this->currentVolume);
+}
+
+/**
+ * @ingroup GA03
+ * @brief Checks if the audio output is muted. See setMute
+ */
+bool KT0937::isMuted()
+{
+    return this->muted;
+}
+
 uint8_t KT0937::getVolume()
 {
+    KT0937LockGuard transaction(&this->configLock);
+
     return this->currentVolume;
 }
 
@@ -394,8 +1172,10 @@ uint8_t KT0937::getVolume()
 
 void KT0937::shutDownADCCH()
 {
+    KT0937LockGuard transaction(&this->configLock);
+
     kt09xx_adc_0 reg ;
-    reg.raw = getRegister(REG_ADC0);
+    reg.raw = getCachedRegister(REG_ADC0);
     reg.refined.CH_ADC_DIS =1;
     //reg.refined.CH_ADC_START = 0;
     setRegister(REG_ADC0,reg.raw);
@@ -412,8 +1192,10 @@ void KT0937::shutDownADCCH()
 
 void KT0937::turnOnADCCH()
 {
+    KT0937LockGuard transaction(&this->configLock);
+
     kt09xx_adc_0 reg ;
-    reg.raw = getRegister(REG_ADC0);
+    reg.raw = getCachedRegister(REG_ADC0);
     reg.refined.CH_ADC_DIS =0;
     reg.refined.CH_ADC_START = 1;
     setRegister(REG_ADC0,reg.raw);
@@ -421,717 +1203,3111 @@ void KT0937::turnOnADCCH()
 
 /**
  * @ingroup GA03
- * @brief set FM Band from 87.5 MHz to 108.0MHz  and frequency step 100kHz
- * 1) 87500 / 50 kHz = 1750 , as 0x06D6 in Hex,  write 0xD6 into LOW_CHAN<7:0> while 
- * write 0x06 into LOW_CHAN<14:8>.
- * 2) 108MHz / 50KHz = 2160, which is 0x870 in Hex, write 0x70 into FM_HIGH_CHAN<7:0> and
- *write 0x08 into FM_HIGH_CHAN<11:8>. 
- * 3) (108MHz -87.5MHz) / 100KHz = 205, which is 0xCD in Hex, write 0xCD into 
- * CHAN_NUM<7:0> then write 0 into CHAN_NUM<11:8>.
- *     
- * @see setup
+ * @brief Sets CH_ADC_WIN<12:0>
+ * @details CH_ADC_WIN<12:0> = (CHAN_NUM<11:0> + CH_GUARD<7:0>) * 2. ADC3 and ADC4 are written in one burst.
  * 
- * @param 
+ * @param chAdcWin  ADC window
  */
+void KT0937::setADCCHWin(uint16_t chAdcWin)
+{
+    KT0937LockGuard transaction(&this->configLock);
 
- void KT0937::setFMBand(uint16_t frequency)
- {
-    this->currentMode = MODE_FM;
-    enableSW(0);
-    shutDownADCCH();
-    uint8_t freqH = ((frequency /50) >> 8);
-    uint8_t freqL = ((frequency/50) & 0x00FF);
-    //set band range . LOW_CHAN<14:8> set to 0X06
-    kt09xx_low_chan_0 reg0 ;
-    reg0.raw = getRegister(REG_LOW_CHAN0);
-    reg0.refined.LOW_CHAN_14_8 =freqH;
-    setRegister(REG_LOW_CHAN0,reg0.raw);
-
-    //set band range. LOW_CHAN<7:0> set to 0xD6
-    kt09xx_low_chan_1 reg1 ;
-    reg1.raw = getRegister(REG_LOW_CHAN1);
-    reg1.refined.LOW_CHAN_7_0 =freqL;
-    setRegister(REG_LOW_CHAN1,reg1.raw);
-
-    //set band range. write 0x08 into FM_HIGH_CHAN<11:8>
-    kt09xx_fm_chan_0 reg2 ;
-    reg2.raw = getRegister(REG_FMCHAN0);
-    reg2.refined.FM_HIGH_CHAN_11_8 =freqH;
-    setRegister(REG_FMCHAN0,reg2.raw);
-
-    //set band range. write 0x70 into FM_HIGH_CHAN<7:0>
-    kt09xx_fm_chan_1 reg3 ;
-    reg3.raw = getRegister(REG_FMCHAN1);
-    reg3.refined.FM_HIGH_CHAN_7_0 =freqL;
-    setRegister(REG_FMCHAN1,reg3.raw);
-
-    //set band range. write 0 into CHAN_NUM<11:8>.
-    kt09xx_chan_num_0 reg4 ;
-    reg4.raw = getRegister(REG_CHAN_NUM0);
-    reg4.refined.CHAN_NUM_11_8 =0;
-    setRegister(REG_CHAN_NUM0,reg4.raw);
-
-    //set band range. write 0xCD into  CHAN_NUM<7:0>
-    kt09xx_chan_num_1 reg5 ;
-    reg5.raw = getRegister(REG_CHAN_NUM1);
-    reg5.refined.CHAN_NUM_7_0 =0;
-    setRegister(REG_CHAN_NUM1,reg5.raw);
-
-    //set FM SPACE. write 0x01 into  FM_SPACE ,set to 100kHz
-    kt09xx_bandcfg_2 reg6 ;
-    reg6.raw = getRegister(REG_BANDCFG2);
-    reg6.refined.FM_SPACE =1;
-    setRegister(REG_BANDCFG2,reg6.raw);
-
-    //set CHAN GUARD. write 0x17 (23) to CH_GUARD
-    kt09xx_guard_2 reg7 ;
-    reg7.raw = getRegister(REG_GUARD2);
-    reg7.refined.CH_GUARD =0x10;
-    setRegister(REG_GUARD2,reg7.raw);
-
-    //set CH_ADC_WIN. CH_ADC_WIN<12:0> =  (CHAN_NUM<11:0> + CH_GUARD<7:0>)  * 2   (205(chan)+17(guard))*2 = 456 as 0x 1C8
-    //set 0x 00 to <CH_ADC_WIN<12:8>, set 0xFB to <CH_ADC_WIN(7:)    
-    kt09xx_adc_3 reg8 ;
-    reg8.raw = getRegister(REG_ADC3);
-    reg8.refined.CH_ADC_WIN_12_8 = 1;
-    setRegister(REG_ADC3,reg8.raw);
-
-    kt09xx_adc_4 reg9 ;
-    reg9.raw = getRegister(REG_ADC4);
-    reg9.refined.CH_ADC_WIN_7_0 = 0xC8;
-    setRegister(REG_ADC4,reg9.raw);
-
-    //set AM_FM = 0 register CHANGE_BAND=1, KT0937 can be working in FM channel mode.
-    kt09xx_fm_chan_0 reg10 ;
-    reg10.raw = getRegister(REG_FMCHAN0);
-    reg10.refined.AM_FM =0;
-    reg10.refined.CHANGE_BAND = 1;
-    setRegister(REG_FMCHAN0,reg10.raw);
+    uint8_t buf[2];
+    getCachedRegisters(REG_ADC3, buf, 2);
 
-    //turn on ADCCH 
-    turnOnADCCH();
+    kt09xx_adc_3 reg0;
+    reg0.raw = buf[0];
+    reg0.refined.CH_ADC_WIN_12_8 = (chAdcWin >> 8) & 0x1F;
+    buf[0] = reg0.raw;
 
- }
+    kt09xx_adc_4 reg1;
+    reg1.raw = buf[1];
+    reg1.refined.CH_ADC_WIN_7_0 = chAdcWin & 0xFF;
+    buf[1] = reg1.raw;
+
+    writeRegisters(REG_ADC3, buf, 2);
+}
 
 /**
  * @ingroup GA03
- * @brief set FM Band from 87.5 MHz to 108.0MHz  and frequency step 100kHz
- * 1) 87500 / 50 kHz = 1750 , as 0x06D6 in Hex,  write 0xD6 into LOW_CHAN<7:0> while 
- * write 0x06 into LOW_CHAN<14:8>.
- * 2) 108MHz / 50KHz = 2160, which is 0x870 in Hex, write 0x70 into FM_HIGH_CHAN<7:0> and
- *write 0x08 into FM_HIGH_CHAN<11:8>. 
- * 3) (108MHz -87.5MHz) / 100KHz = 205, which is 0xCD in Hex, write 0xCD into 
- * CHAN_NUM<7:0> then write 0 into CHAN_NUM<11:8>.
- *     
- * @see setup
+ * @brief Sets the band start channel and the number of channels
+ * @details LOW_CHAN0, LOW_CHAN1, CHAN_NUM0 and CHAN_NUM1 (0x98 ~ 0x9B) are written in one burst.
  * 
- * @param 
+ * @param lowChannel     LOW_CHAN<14:0>. FM: frequency / 50kHz; MW/SW: frequency / 1kHz
+ * @param channelNumber  CHAN_NUM<11:0>. (high frequency - low frequency) / step
  */
- void KT0937::setFMBand()
- {
-    this->currentMode = MODE_FM;
-    enableSW(0);
-    shutDownADCCH();
-    //uint8_t freqH = ((frequency /50) >> 8);
-    //uint8_t freqL = ((frequency/50) & 0x00ff);
-    //set band range . LOW_CHAN<14:8> set to 0X06
-    kt09xx_low_chan_0 reg0 ;
-    reg0.raw = getRegister(REG_LOW_CHAN0);
-    reg0.refined.LOW_CHAN_14_8 =0x06;
-    setRegister(REG_LOW_CHAN0,reg0.raw);
-
-    //set band range. LOW_CHAN<7:0> set to 0xD6
-    kt09xx_low_chan_1 reg1 ;
-    reg1.raw = getRegister(REG_LOW_CHAN1);
-    reg1.refined.LOW_CHAN_7_0 =0xA4;
-    setRegister(REG_LOW_CHAN1,reg1.raw);
-
-    //set band range. write 0x08 into FM_HIGH_CHAN<11:8>
-    kt09xx_fm_chan_0 reg2 ;
-    reg2.raw = getRegister(REG_FMCHAN0);
-    reg2.refined.FM_HIGH_CHAN_11_8 =0x08;
-    setRegister(REG_FMCHAN0,reg2.raw);
-
-    //set band range. write 0x70 into FM_HIGH_CHAN<7:0>
-    kt09xx_fm_chan_1 reg3 ;
-    reg3.raw = getRegister(REG_FMCHAN1);
-    reg3.refined.FM_HIGH_CHAN_7_0 =0x70;
-    setRegister(REG_FMCHAN1,reg3.raw);
-
-    //set band range. write 0 into CHAN_NUM<11:8>.
-    kt09xx_chan_num_0 reg4 ;
-    reg4.raw = getRegister(REG_CHAN_NUM0);
-    reg4.refined.CHAN_NUM_11_8 =0x00;
-    setRegister(REG_CHAN_NUM0,reg4.raw);
-
-    //set band range. write 0xCD into  CHAN_NUM<7:0>
-    kt09xx_chan_num_1 reg5 ;
-    reg5.raw = getRegister(REG_CHAN_NUM1);
-    reg5.refined.CHAN_NUM_7_0 =0xE6;
-    setRegister(REG_CHAN_NUM1,reg5.raw);
-
-    //set FM SPACE. write 0x01 into  FM_SPACE ,set to 100kHz
-    kt09xx_bandcfg_2 reg6 ;
-    reg6.raw = getRegister(REG_BANDCFG2);
-    reg6.refined.FM_SPACE =0x01;
-    setRegister(REG_BANDCFG2,reg6.raw);
-
-    //set CHAN GUARD. write 0x17 (23) to CH_GUARD
-    kt09xx_guard_2 reg7 ;
-    reg7.raw = getRegister(REG_GUARD2);
-    reg7.refined.CH_GUARD =0x17;
-    setRegister(REG_GUARD2,reg7.raw);
-
-    //set CH_ADC_WIN. CH_ADC_WIN<12:0> =  (CHAN_NUM<11:0> + CH_GUARD<7:0>)  * 2   (205(chan)+17(guard))*2 = 456 as 0x 1C8
-    //set 0x 00 to <CH_ADC_WIN<12:8>, set 0xFB to <CH_ADC_WIN(7:)    
-    kt09xx_adc_3 reg8 ;
-    reg8.raw = getRegister(REG_ADC3);
-    reg8.refined.CH_ADC_WIN_12_8 = 1;
-    setRegister(REG_ADC3,reg8.raw);
-
-    kt09xx_adc_4 reg9 ;
-    reg9.raw = getRegister(REG_ADC4);
-    reg9.refined.CH_ADC_WIN_7_0 = 0xFA;
-    setRegister(REG_ADC4,reg9.raw);
-
-    //set AM_FM = 0 register CHANGE_BAND=1, KT0937 can be working in FM channel mode.
-    kt09xx_fm_chan_0 reg10 ;
-    reg10.raw = getRegister(REG_FMCHAN0);
-    reg10.refined.AM_FM =0;
-    setRegister(REG_FMCHAN0,reg10.raw);
-
-    reg10.raw = getRegister(REG_FMCHAN0);
-    reg10.refined.CHANGE_BAND = 1;
-    setRegister(REG_FMCHAN0,reg10.raw);
-
-    reg10.raw = getRegister(REG_FMCHAN0);
-    this->errorCode = reg10.raw;
+void KT0937::setChannelRange(uint16_t lowChannel, uint16_t channelNumber)
+{
+    KT0937LockGuard transaction(&this->configLock);
 
-    //turn on ADCCH 
-    turnOnADCCH();
+    uint8_t buf[4];
+    getCachedRegisters(REG_LOW_CHAN0, buf, 4);
 
- }
+    kt09xx_low_chan_0 reg0;
+    reg0.raw = buf[0];
+    reg0.refined.LOW_CHAN_14_8 = (lowChannel >> 8) & 0x7F;
+    buf[0] = reg0.raw;
 
- void KT0937::setAMBand(uint16_t lowFrequency, uint16_t highFrequency)
- {
-    this->currentMode = MODE_AM;
-    //
- }
+    kt09xx_low_chan_1 reg1;
+    reg1.raw = buf[1];
+    reg1.refined.LOW_CHAN_7_0 = lowChannel & 0xFF;
+    buf[1] = reg1.raw;
 
- void KT0937::setAMBand()
- {
-    this->currentMode = MODE_AM;
-    enableSW(0);
-    shutDownADCCH();
-    
-    //low :522 kHz , hex 522kHz / 1kHz = 522 , 0x020A;
-    //High:1602 kHz, hex 1602kHz / 1kHz = 1602, 0x0654
-    kt09xx_low_chan_0 reg0 ;
-    reg0.raw = getRegister(REG_LOW_CHAN0);
-    reg0.refined.LOW_CHAN_14_8 =0x02;
-    setRegister(REG_LOW_CHAN0,reg0.raw);
-
-    //set band range. LOW_CHAN<7:0> set to 0x0A
-    kt09xx_low_chan_1 reg1 ;
-    reg1.raw = getRegister(REG_LOW_CHAN1);
-    reg1.refined.LOW_CHAN_7_0 =0x0A;
-    setRegister(REG_LOW_CHAN1,reg1.raw);
-
-    //set band range. write 0x06 into AM_HIGH_CHAN<11:8>
-    kt09xx_am_chan_0 reg2 ;
-    reg2.raw = getRegister(REG_AMCHAN0);
-    reg2.refined.AM_HIGH_CHAN_14_8 =0x06;
-    setRegister(REG_AMCHAN0,reg2.raw);
-
-    //set band range. write 0x54 into AM_HIGH_CHAN<7:0>
-    kt09xx_am_chan_1 reg3 ;
-    reg3.raw = getRegister(REG_AMCHAN1);
-    reg3.refined.AM_HIGH_CHAN_7_0 =0x54;
-    setRegister(REG_AMCHAN1,reg3.raw);
-
-    //set band range. write 0 into CHAN_NUM<11:8>.
-    kt09xx_chan_num_0 reg4 ;
-    reg4.raw = getRegister(REG_CHAN_NUM0);
-    reg4.refined.CHAN_NUM_11_8 =0x00;
-    setRegister(REG_CHAN_NUM0,reg4.raw);
-
-    //set band range. write 0xCD into  CHAN_NUM<7:0>
-    kt09xx_chan_num_1 reg5 ;
-    reg5.raw = getRegister(REG_CHAN_NUM1);
-    reg5.refined.CHAN_NUM_7_0 =0x7A;
-    setRegister(REG_CHAN_NUM1,reg5.raw);
-
-    //set AM SPACE. write 0x00 into  AM_SPACE ,set to 1kHz
-    kt09xx_bandcfg_2 reg6 ;
-    reg6.raw = getRegister(REG_BANDCFG2);
-    reg6.refined.MW_SPACE =0x01;
-    setRegister(REG_BANDCFG2,reg6.raw);
-
-    //set CHAN GUARD. write 0x17 (23) to CH_GUARD
-    kt09xx_guard_2 reg7 ;
-    reg7.raw = getRegister(REG_GUARD2);
-    reg7.refined.CH_GUARD =0x17;
-    setRegister(REG_GUARD2,reg7.raw);
-
-    //set CH_ADC_WIN. CH_ADC_WIN<12:0> =  (CHAN_NUM<11:0> + CH_GUARD<7:0>)  * 2   (205(chan)+17(guard))*2 = 456 as 0x 1C8
-    //set 0x 00 to <CH_ADC_WIN<12:8>, set 0xFB to <CH_ADC_WIN(7:)    
-    kt09xx_adc_3 reg8 ;
-    reg8.raw = getRegister(REG_ADC3);
-    reg8.refined.CH_ADC_WIN_12_8 = 0x08;
-    setRegister(REG_ADC3,reg8.raw);
-
-    kt09xx_adc_4 reg9 ;
-    reg9.raw = getRegister(REG_ADC4);
-    reg9.refined.CH_ADC_WIN_7_0 = 0xC6;
-    setRegister(REG_ADC4,reg9.raw);
-
-    //set AM_FM = 1 register CHANGE_BAND=1, KT0937 can be working in AM channel mode.
-    kt09xx_fm_chan_0 reg10 ;
-    reg10.raw = getRegister(REG_FMCHAN0);
-    reg10.refined.AM_FM =1;
-    setRegister(REG_FMCHAN0,reg10.raw);
-
-    reg10.raw = getRegister(REG_FMCHAN0);
-    reg10.refined.CHANGE_BAND = 1;
-    setRegister(REG_FMCHAN0,reg10.raw);
-
-    reg10.raw = getRegister(REG_FMCHAN0);
-    this->errorCode = reg10.raw;
-  
-    //turn on ADCCH 
-    turnOnADCCH();
- }
+    kt09xx_chan_num_0 reg2;
+    reg2.raw = buf[2];
+    reg2.refined.CHAN_NUM_11_8 = (channelNumber >> 8) & 0x0F;
+    buf[2] = reg2.raw;
 
- void KT0937::setSWBand()
- {
-    this->currentMode = MODE_AM;
-    enableSW(1);
-    shutDownADCCH();
-    
-    //low :522 kHz , hex 522kHz / 1kHz = 522 , 0x020A;
-    //High:1602 kHz, hex 1602kHz / 1kHz = 1602, 0x0654
-    kt09xx_low_chan_0 reg0 ;
-    reg0.raw = getRegister(REG_LOW_CHAN0);
-    reg0.refined.LOW_CHAN_14_8 =0x23;
-    setRegister(REG_LOW_CHAN0,reg0.raw);
-
-    //set band range. LOW_CHAN<7:0> set to 0x0A
-    kt09xx_low_chan_1 reg1 ;
-    reg1.raw = getRegister(REG_LOW_CHAN1);
-    reg1.refined.LOW_CHAN_7_0 =0x28;
-    setRegister(REG_LOW_CHAN1,reg1.raw);
-
-    //set band range. write 0x06 into AM_HIGH_CHAN<11:8>
-    kt09xx_am_chan_0 reg2 ;
-    reg2.raw = getRegister(REG_AMCHAN0);
-    reg2.refined.AM_HIGH_CHAN_14_8 =0x27;
-    setRegister(REG_AMCHAN0,reg2.raw);
-
-    //set band range. write 0x54 into AM_HIGH_CHAN<7:0>
-    kt09xx_am_chan_1 reg3 ;
-    reg3.raw = getRegister(REG_AMCHAN1);
-    reg3.refined.AM_HIGH_CHAN_7_0 =0x10;
-    setRegister(REG_AMCHAN1,reg3.raw);
-
-    //set band range. write 0 into CHAN_NUM<11:8>.
-    kt09xx_chan_num_0 reg4 ;
-    reg4.raw = getRegister(REG_CHAN_NUM0);
-    reg4.refined.CHAN_NUM_11_8 =0x00;
-    setRegister(REG_CHAN_NUM0,reg4.raw);
-
-    //set band range. write 0xCD into  CHAN_NUM<7:0>
-    kt09xx_chan_num_1 reg5 ;
-    reg5.raw = getRegister(REG_CHAN_NUM1);
-    reg5.refined.CHAN_NUM_7_0 =0xC8;
-    setRegister(REG_CHAN_NUM1,reg5.raw);
-
-    //set AM SPACE. write 0x00 into  AM_SPACE ,set to 1kHz
-    kt09xx_bandcfg_3 reg6 ;
-    reg6.raw = getRegister(REG_BANDCFG3);
-    reg6.refined.SW_SPACE = 1;
-    setRegister(REG_BANDCFG3,reg6.raw);
-
-    //set CHAN GUARD. write 0x17 (23) to CH_GUARD
-    kt09xx_guard_2 reg7 ;
-    reg7.raw = getRegister(REG_GUARD2);
-    reg7.refined.CH_GUARD =0x17;
-    setRegister(REG_GUARD2,reg7.raw);
-
-    //set CH_ADC_WIN. CH_ADC_WIN<12:0> =  (CHAN_NUM<11:0> + CH_GUARD<7:0>)  * 2   (205(chan)+17(guard))*2 = 456 as 0x 1C8
-    //set 0x 00 to <CH_ADC_WIN<12:8>, set 0xFB to <CH_ADC_WIN(7:)    
-    kt09xx_adc_3 reg8 ;
-    reg8.raw = getRegister(REG_ADC3);
-    reg8.refined.CH_ADC_WIN_12_8 = 0x01;
-    setRegister(REG_ADC3,reg8.raw);
-
-    kt09xx_adc_4 reg9 ;
-    reg9.raw = getRegister(REG_ADC4);
-    reg9.refined.CH_ADC_WIN_7_0 = 0xBE;
-    setRegister(REG_ADC4,reg9.raw);
-
-    //set AM_FM = 1 register CHANGE_BAND=1, KT0937 can be working in AM channel mode.
-    kt09xx_fm_chan_0 reg10 ;
-    reg10.raw = getRegister(REG_FMCHAN0);
-    reg10.refined.AM_FM =1;
-    setRegister(REG_FMCHAN0,reg10.raw);
-
-    reg10.raw = getRegister(REG_FMCHAN0);
-    reg10.refined.CHANGE_BAND = 1;
-    setRegister(REG_FMCHAN0,reg10.raw);
-
-    reg10.raw = getRegister(REG_FMCHAN0);
-    this->errorCode = reg10.raw;  
-    //turn on ADCCH 
-    turnOnADCCH();
- }
+    kt09xx_chan_num_1 reg3;
+    reg3.raw = buf[3];
+    reg3.refined.CHAN_NUM_7_0 = channelNumber & 0xFF;
+    buf[3] = reg3.raw;
 
+    writeRegisters(REG_LOW_CHAN0, buf, 4);
+}
 
- void KT0937::setSWBand(uint16_t lowFrequency, uint16_t highFrequency, uint16_t chanNumber )
-  {
-    this->currentMode = MODE_AM;
-    enableSW(1);
-    shutDownADCCH();
-    //calc the lowFrequency
-    uint8_t byteHigh = uint8_t((lowFrequency>> 8)& 0x007F);
-    uint8_t byteLow = uint8_t((lowFrequency) & 0x00FF);
-    
-        //low :522 kHz , hex 522kHz / 1kHz = 522 , 0x020A;
-    //High:1602 kHz, hex 1602kHz / 1kHz = 1602, 0x0654
-    kt09xx_low_chan_0 reg0 ;
-    reg0.raw = getRegister(REG_LOW_CHAN0);
-    reg0.refined.LOW_CHAN_14_8 =byteHigh;
-    setRegister(REG_LOW_CHAN0,reg0.raw);
-
-    //set band range. LOW_CHAN<7:0> set to 0x0A
-    kt09xx_low_chan_1 reg1 ;
-    reg1.raw = getRegister(REG_LOW_CHAN1);
-    reg1.refined.LOW_CHAN_7_0 =byteLow;
-    setRegister(REG_LOW_CHAN1,reg1.raw);
-
-    //calc the HighFrequency
-    byteHigh = uint8_t((highFrequency >> 8)&0x007F);
-    byteLow =uint8_t ((highFrequency) & 0x00FF);
-    
+/**
+ * @ingroup GA03
+ * @brief Sets FM_HIGH_CHAN<11:0> (band end channel, frequency / 50kHz)
+ * @details FMCHAN0 and FMCHAN1 are written in one burst. AM_FM is kept, CHANGE_BAND is not set.
+ * 
+ * @param highChannel  FM_HIGH_CHAN<11:0>
+ */
+void KT0937::setFMHighChannel(uint16_t highChannel)
+{
+    KT0937LockGuard transaction(&this->configLock);
 
-    //set band range. write 0x06 into AM_HIGH_CHAN<11:8>
-    kt09xx_am_chan_0 reg2 ;
-    reg2.raw = getRegister(REG_AMCHAN0);
-    reg2.refined.AM_HIGH_CHAN_14_8 =byteHigh;
-    setRegister(REG_AMCHAN0,reg2.raw);
-
-    //set band range. write 0x54 into AM_HIGH_CHAN<7:0>
-    kt09xx_am_chan_1 reg3 ;
-    reg3.raw = getRegister(REG_AMCHAN1);
-    reg3.refined.AM_HIGH_CHAN_7_0 =byteLow;
-    setRegister(REG_AMCHAN1,reg3.raw);
-
-    //set SW SPACE. write 0x01 into  SW_SPACE ,set to 5kHz
-    kt09xx_bandcfg_3 reg6 ;
-    reg6.raw = getRegister(REG_BANDCFG3);
-    reg6.refined.SW_SPACE = 0;
-    setRegister(REG_BANDCFG3,reg6.raw);
-
-    //calc the Channel Number , with sw_space as  step
-    byteHigh = uint8_t((chanNumber >> 8)&0x000F);
-    byteLow = uint8_t((chanNumber) & 0x00FF);
-
-
-    //set band range. write 0 into CHAN_NUM<11:8>.
-    kt09xx_chan_num_0 reg4 ;
-    reg4.raw = getRegister(REG_CHAN_NUM0);
-    reg4.refined.CHAN_NUM_11_8 =byteHigh;
-    setRegister(REG_CHAN_NUM0,reg4.raw);
-
-    //set band range. write 0xCD into  CHAN_NUM<7:0>
-    kt09xx_chan_num_1 reg5 ;
-    reg5.raw = getRegister(REG_CHAN_NUM1);
-    reg5.refined.CHAN_NUM_7_0 =byteLow;
-    setRegister(REG_CHAN_NUM1,reg5.raw);
-    
-    //set CHAN GUARD. write 0x17 (23) to CH_GUARD
-    kt09xx_guard_2 reg7 ;
-    reg7.raw = getRegister(REG_GUARD2);
-    reg7.refined.CH_GUARD =0x17;
-    setRegister(REG_GUARD2,reg7.raw);
-
-
-
-    //calc the CH_ADC_WIN
-    uint16_t ch_adc_win =0;
-    ch_adc_win = (chanNumber + 23) * 2;  // ( channel number  + CH_GUARD ) * 2  
-    byteHigh = uint8_t((ch_adc_win >> 8)& 0x001F);
-    byteLow = uint8_t((ch_adc_win) & 0x00FF);
-
-    //set CH_ADC_WIN. CH_ADC_WIN<12:0> =  (CHAN_NUM<11:0> + CH_GUARD<7:0>)  * 2   (205(chan)+17(guard))*2 = 456 as 0x 1C8
-    //set 0x 00 to <CH_ADC_WIN<12:8>, set 0xFB to <CH_ADC_WIN(7:)    
-    kt09xx_adc_3 reg8 ;
-    reg8.raw = getRegister(REG_ADC3);
-    reg8.refined.CH_ADC_WIN_12_8 = byteHigh;
-    setRegister(REG_ADC3,reg8.raw);
-
-    kt09xx_adc_4 reg9 ;
-    reg9.raw = getRegister(REG_ADC4);
-    reg9.refined.CH_ADC_WIN_7_0 = byteLow;
-    setRegister(REG_ADC4,reg9.raw);
-
-  
-    //set AM_FM = 1 register CHANGE_BAND=1, KT0937 can be working in AM channel mode.
-    kt09xx_fm_chan_0 reg10 ;
-    reg10.raw = getRegister(REG_FMCHAN0);
-    reg10.refined.AM_FM =1;
-    reg10.refined.CHANGE_BAND = 1;
-    setRegister(REG_FMCHAN0,reg10.raw);
-    delay(5);
-    reg10.raw = getRegister(REG_FMCHAN0);
-    this->errorCode = reg10.raw;
-
-   //turn on ADCCH 
-    turnOnADCCH();
+    uint8_t buf[2];
+    getCachedRegisters(REG_FMCHAN0, buf, 2);
 
-    
+    kt09xx_fm_chan_0 reg0;
+    reg0.raw = buf[0];
+    reg0.refined.FM_HIGH_CHAN_11_8 = (highChannel >> 8) & 0x0F;
+    buf[0] = reg0.raw;
 
+    kt09xx_fm_chan_1 reg1;
+    reg1.raw = buf[1];
+    reg1.refined.FM_HIGH_CHAN_7_0 = highChannel & 0xFF;
+    buf[1] = reg1.raw;
 
- }
+    writeRegisters(REG_FMCHAN0, buf, 2);
+}
 
+/**
+ * @ingroup GA03
+ * @brief Sets AM_HIGH_CHAN<14:0> (band end channel, frequency / 1kHz)
+ * @details AMCHAN0 and AMCHAN1 are written in one burst.
+ * 
+ * @param highChannel  AM_HIGH_CHAN<14:0>
+ */
+void KT0937::setAMHighChannel(uint16_t highChannel)
+{
+    KT0937LockGuard transaction(&this->configLock);
 
+    uint8_t buf[2];
+    getCachedRegisters(REG_AMCHAN0, buf, 2);
 
+    kt09xx_am_chan_0 reg0;
+    reg0.raw = buf[0];
+    reg0.refined.AM_HIGH_CHAN_14_8 = (highChannel >> 8) & 0x7F;
+    buf[0] = reg0.raw;
 
- void KT0937::enableDialMode()
- {
-    //set CH_PIN<1:0> to  10
-    kt09xx_gpiocfg_2 reg ;
-    reg.raw = getRegister(REG_GPIOCFG2);
-    reg.refined.CH_PIN = 2;
-    setRegister(REG_GPIOCFG2,reg.raw);
- }
+    kt09xx_am_chan_1 reg1;
+    reg1.raw = buf[1];
+    reg1.refined.AM_HIGH_CHAN_7_0 = highChannel & 0xFF;
+    buf[1] = reg1.raw;
 
- void KT0937::disableFMSoftMute(bool disable)
- {
-    kt09xx_mutecfg_0 reg;
-    reg.raw = getRegister(REG_MUTECFG0);
-    reg.refined.FM_DSMUTE = disable;
-    setRegister(REG_MUTECFG0,reg.raw);
- }
+    writeRegisters(REG_AMCHAN0, buf, 2);
+}
 
- void KT0937::disableMWSoftMute(bool disable)
- {
-    kt09xx_mutecfg_0 reg;
-    reg.raw = getRegister(REG_MUTECFG0);
-    reg.refined.MW_DSMUTE = disable;
-    setRegister(REG_MUTECFG0,reg.raw);
- }
 
- void KT0937::disableSWSoftMute(bool disable)
- {
-    kt09xx_sw_softmute_0 reg;
-    reg.raw = getRegister(REG_SW_SOFTMUTE0);
-    reg.refined.SW_DSMUTE = disable;
-    setRegister(REG_SW_SOFTMUTE0,reg.raw);
- }
+/**
+ * @ingroup GA03
+ * @brief Bits of bandRegisters owned by a FM, MW or SW band (SW_EN, *_SPACE, CH_ADC_WIN, AM_FM, *_HIGH_CHAN, 
+ * @brief LOW_CHAN, CHAN_NUM and CH_GUARD). CHANGE_BAND is set apart by setBand.
+ */
+static const uint8_t fmBandMask[BAND_REG_COUNT] = {0x10, 0x30, 0x00, 0x1F, 0xFF, 0x4F, 0xFF, 0x00, 0x00, 0x7F, 0xFF, 0x0F, 0xFF, 0xFF};
+static const uint8_t mwBandMask[BAND_REG_COUNT] = {0x10, 0x03, 0x00, 0x1F, 0xFF, 0x40, 0x00, 0x7F, 0xFF, 0x7F, 0xFF, 0x0F, 0xFF, 0xFF};
+static const uint8_t swBandMask[BAND_REG_COUNT] = {0x10, 0x00, 0x03, 0x1F, 0xFF, 0x40, 0x00, 0x7F, 0xFF, 0x7F, 0xFF, 0x0F, 0xFF, 0xFF};
 
- void KT0937::disableMWAFC(bool disable)
- {
-    kt09xx_afc_3 reg;
-    reg.raw = getRegister(REG_AFC3);
-    reg.refined.MW_AFCD = disable;
-    setRegister(REG_AFC3,reg.raw);
- }
+/**
+ * @ingroup GA03
+ * @brief Writes the registers of a list whose content differs from the device
+ * @details Registers already holding their image value (see isShadowEqual) are skipped. The others are written 
+ * @details one burst per run of consecutive addresses.
+ * 
+ * @param regs   register numbers, in address order
+ * @param image  image[i] is written into regs[i]
+ * @param n      number of registers
+ */
+void KT0937::writeRegisterImage(const uint8_t *regs, const uint8_t *image, uint8_t n)
+{
+    uint8_t i = 0;
+    while (i < n)
+    {
+        if (isShadowEqual(regs[i], image[i]))
+        {
+            i++;
+            continue;
+        }
+
+        uint8_t run = 1;
+        while ((i + run) < n && regs[i + run] == regs[i] + run && !isShadowEqual(regs[i + run], image[i + run]))
+            run++;
+        writeRegisters(regs[i], &image[i], run);
+        i += run;
+    }
+}
 
- 
+/**
+ * @ingroup GA03
+ * @brief Gets the FM channel step configured in FM_SPACE
+ * @return 200, 100 or 50 (kHz)
+ */
+uint8_t KT0937::getFMSpaceKHz()
+{
+    KT0937LockGuard transaction(&this->configLock);
 
-//disable FM AFC
-void KT0937::disableFMAFC(bool disable)
- {
-    kt09xx_afc_2 reg;
-    reg.raw = getRegister(REG_AFC2);
-    reg.refined.FM_AFCD = disable;
-    setRegister(REG_AFC2,reg.raw);
- }
+    static const uint8_t spaceKHz[4] = {200, 100, 50, 50};
+    kt09xx_bandcfg_2 reg;
+    reg.raw = getCachedRegister(REG_BANDCFG2);
+    return spaceKHz[reg.refined.FM_SPACE];
+}
 
- //disable SW AFC
-void KT0937::disableSWAFC(bool disable)
- {
-    kt09xx_swcfg_0 reg;
-    reg.raw = getRegister(REG_SW_CFG0);
-    reg.refined.SW_AFCD = disable;
-    setRegister(REG_SW_CFG0,reg.raw);
- }
+/**
+ * @ingroup GA03
+ * @brief Gets the MW channel step configured in MW_SPACE
+ * @return 1, 9 or 10 (kHz)
+ */
+uint8_t KT0937::getMWSpaceKHz()
+{
+    KT0937LockGuard transaction(&this->configLock);
 
+    static const uint8_t spaceKHz[4] = {1, 9, 10, 10};
+    kt09xx_bandcfg_2 reg;
+    reg.raw = getCachedRegister(REG_BANDCFG2);
+    return spaceKHz[reg.refined.MW_SPACE];
+}
 
- /* 
- * mwIFBW   000 : 1.2kHz
- *          001 : 2.4kHz
- *          010 : 3.6kHz
- *          011 : 4.8KHz
-            100 : 6.0KHz
- *
+/**
+ * @ingroup GA03
+ * @brief Computes the band register image of a given band
+ * @details The band fields are merged into the current content (shadow register map) of the registers 
+ * @details listed in bandRegisters. CHANGE_BAND is not set. 
+ * @details Images can be computed once (e.g. in setup, one per entry of a band table) and applied later 
+ * @details with setBand(const kt09xx_band_image &).
+ * 
+ * @param band       band descriptor
+ * @param bandImage  receives the band register image
  */
- 
- void KT0937::setAMIFBW(uint8_t mwIFBW)
- {
-    kt09xx_amdsp_0 reg;
-    reg.raw = getRegister(REG_AMDSP0);
-    reg.refined.FLT_SEL = mwIFBW;
-    setRegister(REG_AMDSP0,reg.raw);
- }
-
- uint16_t KT0937::getCurrentFrequency()
- {
-    kt09xx_status_6 regH;
-    regH.raw = getRegister(REG_STATUS6);
-    kt09xx_status_7 regL;
-    regL.raw = getRegister(REG_STATUS7);
-    this->currentFrequency = ((regH.raw << 8)|regL.raw);
-    return this->currentFrequency;
+void KT0937::getBandImage(const kt09xx_band &band, kt09xx_band_image &bandImage)
+{
+    KT0937LockGuard transaction(&this->configLock);
+
+    uint8_t *image = bandImage.reg;
+
+    for (uint8_t i = 0; i < BAND_REG_COUNT; i++)
+        image[i] = getCachedRegister(bandRegisters[i]);
+
+    kt09xx_bandcfg_0 bandcfg0;
+    bandcfg0.raw = image[0];
+    bandcfg0.refined.SW_EN = band.swEnable;
+    image[0] = bandcfg0.raw;
+
+    kt09xx_bandcfg_2 bandcfg2;
+    bandcfg2.raw = image[1];
+    kt09xx_bandcfg_3 bandcfg3;
+    bandcfg3.raw = image[2];
+    if (band.mode == MODE_FM)
+        bandcfg2.refined.FM_SPACE = band.space;
+    else if (band.swEnable)
+        bandcfg3.refined.SW_SPACE = band.space;
+    else
+        bandcfg2.refined.MW_SPACE = band.space;
+    image[1] = bandcfg2.raw;
+    image[2] = bandcfg3.raw;
+
+    kt09xx_adc_3 adc3;
+    adc3.raw = image[3];
+    adc3.refined.CH_ADC_WIN_12_8 = (band.chAdcWin >> 8) & 0x1F;
+    image[3] = adc3.raw;
+
+    kt09xx_adc_4 adc4;
+    adc4.raw = image[4];
+    adc4.refined.CH_ADC_WIN_7_0 = band.chAdcWin & 0xFF;
+    image[4] = adc4.raw;
+
+    kt09xx_fm_chan_0 fmchan0;
+    fmchan0.raw = image[5];
+    fmchan0.refined.AM_FM = band.mode;
+    fmchan0.refined.CHANGE_BAND = 0;
+    kt09xx_fm_chan_1 fmchan1;
+    fmchan1.raw = image[6];
+    kt09xx_am_chan_0 amchan0;
+    amchan0.raw = image[7];
+    kt09xx_am_chan_1 amchan1;
+    amchan1.raw = image[8];
+    if (band.mode == MODE_FM)
+    {
+        fmchan0.refined.FM_HIGH_CHAN_11_8 = (band.highChannel >> 8) & 0x0F;
+        fmchan1.refined.FM_HIGH_CHAN_7_0 = band.highChannel & 0xFF;
+    }
+    else
+    {
+        amchan0.refined.AM_HIGH_CHAN_14_8 = (band.highChannel >> 8) & 0x7F;
+        amchan1.refined.AM_HIGH_CHAN_7_0 = band.highChannel & 0xFF;
+    }
+    image[5] = fmchan0.raw;
+    image[6] = fmchan1.raw;
+    image[7] = amchan0.raw;
+    image[8] = amchan1.raw;
+
+    kt09xx_low_chan_0 low0;
+    low0.raw = image[9];
+    low0.refined.LOW_CHAN_14_8 = (band.lowChannel >> 8) & 0x7F;
+    image[9] = low0.raw;
+
+    kt09xx_low_chan_1 low1;
+    low1.raw = image[10];
+    low1.refined.LOW_CHAN_7_0 = band.lowChannel & 0xFF;
+    image[10] = low1.raw;
+
+    kt09xx_chan_num_0 num0;
+    num0.raw = image[11];
+    num0.refined.CHAN_NUM_11_8 = (band.channelNumber >> 8) & 0x0F;
+    image[11] = num0.raw;
+
+    kt09xx_chan_num_1 num1;
+    num1.raw = image[12];
+    num1.refined.CHAN_NUM_7_0 = band.channelNumber & 0xFF;
+    image[12] = num1.raw;
+
+    kt09xx_guard_2 guard2;
+    guard2.raw = image[13];
+    guard2.refined.CH_GUARD = band.guard;
+    image[13] = guard2.raw;
+}
 
- }
+/**
+ * @ingroup GA03
+ * @brief Records the edges of a band register image as the seek / scan range. See seekUp
+ * @details Single frequency images (CHAN_NUM = 0, see setChannel) leave the range unchanged.
+ * 
+ * @param image  band registers, in the bandRegisters order. currentMode must be the mode of the image
+ */
+void KT0937::setBandRange(const uint8_t *image)
+{
+    if ((((image[11] & 0x0F) << 8) | image[12]) == 0)
+        return;
 
+    this->bandLowChannel = ((uint16_t) (image[9] & 0x7F) << 8) | image[10];
+    this->bandHighChannel = (this->currentMode == MODE_FM) ? ((uint16_t) (image[5] & 0x0F) << 8) | image[6]
+                                                           : ((uint16_t) (image[7] & 0x7F) << 8) | image[8];
+}
 
- uint8_t KT0937::getAMRSSI()
-{   
-    kt09xx_am_status_0 reg;
-    reg.raw = getRegister(REG_AMSTATUS0);
-    this->currentAMRSSI = reg.refined.AM_RSSI + 3;  //dBm = RSSI -110 ; dBuV = RSSI - 3; dBuVEMF = RSSI + 3; 
-    return this->currentAMRSSI;
+/**
+ * @ingroup GA03
+ * @brief Receiver path (CALIBRATION_FM, CALIBRATION_MW or CALIBRATION_SW) of a band register image
+ * @param image  band registers, in the bandRegisters order
+ */
+static uint8_t getImageCalibrationBand(const uint8_t *image)
+{
+    kt09xx_bandcfg_0 bandcfg0;
+    kt09xx_fm_chan_0 fmchan0;
+    bandcfg0.raw = image[0];
+    fmchan0.raw = image[5];
+    if (fmchan0.refined.AM_FM == MODE_FM)
+        return CALIBRATION_FM;
+    return bandcfg0.refined.SW_EN ? CALIBRATION_SW : CALIBRATION_MW;
 }
 
-uint8_t KT0937::getAMSNR()
+/**
+ * @ingroup GA03
+ * @brief Merges the bits owned by a band into the shadow register map and makes it the current band
+ * @details Sets currentMode and the seek / scan range (see setBandRange) at once, so it is only used by setBand. 
+ * @details queueBand switches them when the band lands (see loadBandState).
+ * 
+ * @param bandImage  band register image. See getBandImage
+ * @param image      receives the band registers as the device will hold them, in the bandRegisters order
+ * @return mask of the bits owned by the band (fmBandMask, mwBandMask or swBandMask)
+ */
+const uint8_t *KT0937::mergeBandImage(const kt09xx_band_image &bandImage, uint8_t *image)
+{
+    kt09xx_bandcfg_0 bandcfg0;
+    kt09xx_fm_chan_0 fmchan0;
+
+    bandcfg0.raw = bandImage.reg[0];
+    fmchan0.raw = bandImage.reg[5];
+    const uint8_t *mask = (fmchan0.refined.AM_FM == MODE_FM) ? fmBandMask : (bandcfg0.refined.SW_EN ? swBandMask : mwBandMask);
+
+    for (uint8_t i = 0; i < BAND_REG_COUNT; i++)
+        image[i] = (getCachedRegister(bandRegisters[i]) & ~mask[i]) | (bandImage.reg[i] & mask[i]);
+
+    setCurrentMode(fmchan0.refined.AM_FM);
+    setBandRange(image);
+    return mask;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Takes currentMode and the seek / scan range from the band registers of the shadow register map
+ * @details Run by poll() once a band queued with queueBand has landed (COMMAND_BAND_STATE).
+ */
+void KT0937::loadBandState()
+{
+    uint8_t image[BAND_REG_COUNT];
+    kt09xx_fm_chan_0 fmchan0;
+
+    saveBandRegisters(image);
+    fmchan0.raw = image[5];
+    setCurrentMode(fmchan0.refined.AM_FM);
+    setBandRange(image);
+}
+
+/**
+ * @ingroup GA03
+ * @brief Sets currentMode under the bus lock, so status reads of other tasks never see it half written
+ * @details currentMode is read by the status reads (see readCurrentMode), which do not take the config lock.
+ * 
+ * @param mode  MODE_FM or MODE_AM
+ */
+void KT0937::setCurrentMode(uint8_t mode)
+{
+    KT0937LockGuard bus(&this->busLock);
+    this->currentMode = mode;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Reads currentMode under the bus lock. See setCurrentMode
+ * @return MODE_FM or MODE_AM
+ */
+uint8_t KT0937::readCurrentMode()
+{
+    KT0937LockGuard bus(&this->busLock);
+    return this->currentMode;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Switches the device to a given band register image
+ * @details Follows the Programming Guide band switch steps: shut down the ADC of CH pin, write the band 
+ * @details registers, set CHANGE_BAND (the timing policy waits until the device clears it) and turn on the 
+ * @details ADC of CH pin. 
+ * @details The bits owned by the band are merged into the shadow register map and only the registers that 
+ * @details change are written, one burst per run of consecutive registers. FMCHAN0 is written last, together 
+ * @details with CHANGE_BAND, so AM_FM and FM_HIGH_CHAN<11:8> do not cost an extra transaction.
+ * 
+ * @param bandImage  band register image. See getBandImage
+ */
+void KT0937::setBand(const kt09xx_band_image &bandImage)
+{
+    KT0937LockGuard transaction(&this->configLock);
+
+    uint8_t image[BAND_REG_COUNT];
+    kt09xx_fm_chan_0 fmchan0;
+
+    mergeBandImage(bandImage, image);
+    shutDownADCCH();
+
+    writeRegisterImage(bandRegisters, image, 5);                                 // BANDCFG0 ~ ADC4
+    writeRegisterImage(&bandRegisters[6], &image[6], BAND_REG_COUNT - 6);        // FMCHAN1 ~ GUARD2
+    applyRSSIBias(getImageCalibrationBand(image));
+
+    //set CHANGE_BAND=1, KT0937 will work with the new band.
+    fmchan0.raw = image[5];
+    fmchan0.refined.CHANGE_BAND = 1;
+    setRegister(REG_FMCHAN0, fmchan0.raw);
+
+    //turn on ADCCH 
+    turnOnADCCH();
+}
+
+/**
+ * @ingroup GA03
+ * @brief Switches the device to a given band
+ * @details Same as setBand(const kt09xx_band_image &) with an image computed on the fly.
+ * 
+ * @param band  band descriptor. See makeBand
+ */
+void KT0937::setBand(const kt09xx_band &band)
+{
+    KT0937LockGuard transaction(&this->configLock);
+
+    kt09xx_band_image image;
+
+    getBandImage(band, image);
+    setBand(image);
+}
+
+/**
+ * @ingroup GA03
+ * @brief set FM Band to a single frequency
+ * @details LOW_CHAN<14:0> and FM_HIGH_CHAN<11:0> are set to frequency / 50kHz and CHAN_NUM<11:0> to 0.
+ * @details Same unit as setFMBand(uint16_t, uint16_t).
+ *     
+ * @param frequency  frequency in 10kHz units. E.g. 10110 = 101.10MHz
+ */
+ void KT0937::setFMBand(uint16_t frequency)
+ {
+    KT0937LockGuard transaction(&this->configLock);
+
+    uint16_t channel = (uint32_t) frequency * 10 / FM_CHANNEL_KHZ;
+    setBand(makeBand(channel, channel, 0, FM_SPACE_100KHZ, 0x10, MODE_FM, 0));
+ }
+
+/**
+ * @ingroup GA03
+ * @brief set FM Band from 85.0 MHz to 108.0MHz  and frequency step 100kHz
+ * 1) 85000 / 50 kHz = 1700 , as 0x06A4 in Hex,  write 0xA4 into LOW_CHAN<7:0> while 
+ * write 0x06 into LOW_CHAN<14:8>.
+ * 2) 108MHz / 50KHz = 2160, which is 0x870 in Hex, write 0x70 into FM_HIGH_CHAN<7:0> and
+ *write 0x08 into FM_HIGH_CHAN<11:8>. 
+ * 3) (108MHz -85MHz) / 100KHz = 230, which is 0xE6 in Hex, write 0xE6 into 
+ * CHAN_NUM<7:0> then write 0 into CHAN_NUM<11:8>.
+ *     
+ * @see setBand
+ */
+ void KT0937::setFMBand()
+ {
+    KT0937LockGuard transaction(&this->configLock);
+
+    setBand(KT0937_FM_BAND);
+ }
+
+/**
+ * @ingroup GA03
+ * @brief set FM Band with arbitrary edges. E.g. 64.0 ~ 108.0MHz (OIRT / Japan)
+ * @details The channel step is the one configured in FM_SPACE (100kHz after setup). CHAN_NUM and CH_ADC_WIN 
+ * @details are derived from it. Only the band registers that differ from the current band are written.
+ * @details An invalid range (lowFrequency >= highFrequency, too many channels) sets errorCode to ERR_BAND_RANGE.
+ * 
+ * @param lowFrequency   low band edge in 10kHz units. E.g. 6400 = 64.00MHz
+ * @param highFrequency  high band edge in 10kHz units. E.g. 10800 = 108.00MHz
+ */
+ void KT0937::setFMBand(uint16_t lowFrequency, uint16_t highFrequency)
+ {
+    KT0937LockGuard transaction(&this->configLock);
+
+    uint32_t lowKHz = (uint32_t) lowFrequency * 10;
+    uint32_t highKHz = (uint32_t) highFrequency * 10;
+    uint32_t chanNumber = (lowKHz < highKHz) ? (highKHz - lowKHz) / getFMSpaceKHz() : 0;
+
+    if (chanNumber == 0 || chanNumber > 0x0FFF || (highKHz / FM_CHANNEL_KHZ) > 0x0FFF)
+    {
+        this->errorCode = ERR_BAND_RANGE;
+        return;
+    }
+
+    kt09xx_bandcfg_2 reg;
+    reg.raw = getCachedRegister(REG_BANDCFG2);
+    setBand(makeBand(lowKHz / FM_CHANNEL_KHZ, highKHz / FM_CHANNEL_KHZ, chanNumber, reg.refined.FM_SPACE, 0x17, MODE_FM, 0));
+ }
+
+/**
+ * @ingroup GA03
+ * @brief set MW / LW Band with arbitrary edges. E.g. 153 ~ 279kHz (LW), 520 ~ 1710kHz (MW)
+ * @details The channel step is the one configured in MW_SPACE (9kHz by default). CHAN_NUM and CH_ADC_WIN 
+ * @details are derived from it. Only the band registers that differ from the current band are written.
+ * @details An invalid range (lowFrequency >= highFrequency, too many channels) sets errorCode to ERR_BAND_RANGE.
+ * 
+ * @param lowFrequency   low band edge (kHz)
+ * @param highFrequency  high band edge (kHz)
+ */
+ void KT0937::setAMBand(uint16_t lowFrequency, uint16_t highFrequency)
+ {
+    KT0937LockGuard transaction(&this->configLock);
+
+    uint16_t chanNumber = (lowFrequency < highFrequency) ? (highFrequency - lowFrequency) / getMWSpaceKHz() : 0;
+
+    if (chanNumber == 0 || chanNumber > 0x0FFF || highFrequency > 0x7FFF)
+    {
+        this->errorCode = ERR_BAND_RANGE;
+        return;
+    }
+
+    kt09xx_bandcfg_2 reg;
+    reg.raw = getCachedRegister(REG_BANDCFG2);
+    setBand(makeBand(lowFrequency, highFrequency, chanNumber, reg.refined.MW_SPACE, 0x17, MODE_AM, 0));
+ }
+
+/**
+ * @ingroup GA03
+ * @brief set MW Band from 522kHz to 1602kHz and frequency step 9kHz
+ * @see setBand
+ */
+ void KT0937::setAMBand()
+ {
+    KT0937LockGuard transaction(&this->configLock);
+
+    setBand(KT0937_MW_BAND);
+ }
+
+/**
+ * @ingroup GA03
+ * @brief set SW Band from 9000kHz to 10000kHz and frequency step 5kHz
+ * @see setBand
+ */
+ void KT0937::setSWBand()
+ {
+    KT0937LockGuard transaction(&this->configLock);
+
+    setBand(KT0937_SW_BAND);
+ }
+
+/**
+ * @ingroup GA03
+ * @brief set SW Band with frequency step 1kHz
+ *     
+ * @param lowFrequency   low band edge (kHz)
+ * @param highFrequency  high band edge (kHz)
+ * @param chanNumber     number of channels. (highFrequency - lowFrequency) / 1kHz
+ */
+ void KT0937::setSWBand(uint16_t lowFrequency, uint16_t highFrequency, uint16_t chanNumber )
+ {
+    KT0937LockGuard transaction(&this->configLock);
+
+    setBand(makeSWBand(lowFrequency, highFrequency, chanNumber));
+ }
+
+
+/**
+ * @ingroup GA03
+ * @brief Gets the channel step of the current band, in RDCHAN units
+ * @return FM: FM_SPACE / 50kHz; MW: MW_SPACE (kHz); SW: SW_SPACE (kHz)
+ */
+uint16_t KT0937::getChannelStep()
+{
+    KT0937LockGuard transaction(&this->configLock);
+
+    static const uint8_t swSpaceKHz[4] = {1, 5, 9, 10};
+
+    if (this->currentMode == MODE_FM)
+        return getFMSpaceKHz() / FM_CHANNEL_KHZ;
+
+    kt09xx_bandcfg_0 bandcfg0;
+    bandcfg0.raw = getCachedRegister(REG_BANDCFG0);
+    if (!bandcfg0.refined.SW_EN)
+        return getMWSpaceKHz();
+
+    kt09xx_bandcfg_3 bandcfg3;
+    bandcfg3.raw = getCachedRegister(REG_BANDCFG3);
+    return swSpaceKHz[bandcfg3.refined.SW_SPACE];
+}
+
+/**
+ * @ingroup GA03
+ * @brief Narrows a band register image to one channel
+ * @details LOW_CHAN and FM_HIGH_CHAN (FM) or AM_HIGH_CHAN (MW/SW) are set to the channel, CHAN_NUM to 0.
+ * 
+ * @param image    band registers, in the bandRegisters order. Entries 5 ~ 12 are used
+ * @param channel  FM: frequency / 50kHz; MW/SW: frequency / 1kHz
+ * @param mode     MODE_FM or MODE_AM
+ */
+static void setImageChannel(uint8_t *image, uint16_t channel, uint8_t mode)
+{
+    if (mode == MODE_FM)
+    {
+        kt09xx_fm_chan_0 fmchan0;
+        fmchan0.raw = image[5];
+        fmchan0.refined.FM_HIGH_CHAN_11_8 = (channel >> 8) & 0x0F;
+        image[5] = fmchan0.raw;
+        image[6] = channel & 0xFF;                                  // FM_HIGH_CHAN<7:0>
+    }
+    else
+    {
+        kt09xx_am_chan_0 amchan0;
+        amchan0.raw = image[7];
+        amchan0.refined.AM_HIGH_CHAN_14_8 = (channel >> 8) & 0x7F;
+        image[7] = amchan0.raw;
+        image[8] = channel & 0xFF;                                  // AM_HIGH_CHAN<7:0>
+    }
+
+    kt09xx_low_chan_0 low0;
+    low0.raw = image[9];
+    low0.refined.LOW_CHAN_14_8 = (channel >> 8) & 0x7F;
+    image[9] = low0.raw;
+    image[10] = channel & 0xFF;                                     // LOW_CHAN<7:0>
+
+    kt09xx_chan_num_0 num0;
+    num0.raw = image[11];
+    num0.refined.CHAN_NUM_11_8 = 0;
+    image[11] = num0.raw;
+    image[12] = 0;                                                  // CHAN_NUM<7:0>
+}
+
+/**
+ * @ingroup GA03
+ * @brief Writes the band registers that select a channel, except FMCHAN0
+ * @details LOW_CHAN and FM_HIGH_CHAN / AM_HIGH_CHAN are set to the channel and CHAN_NUM to 0. Only the bytes 
+ * @details that change are written. The device keeps the current channel until CHANGE_BAND is set.
+ * 
+ * @param channel  FM: frequency / 50kHz; MW/SW: frequency / 1kHz
+ * @return FMCHAN0 content that completes the tuning (FM_HIGH_CHAN<11:8> and CHANGE_BAND set)
+ */
+uint8_t KT0937::prepareChannel(uint16_t channel)
+{
+    uint8_t image[BAND_REG_COUNT];
+
+    for (uint8_t i = 5; i <= 12; i++)
+        image[i] = getCachedRegister(bandRegisters[i]);
+    setImageChannel(image, channel, this->currentMode);
+    writeRegisterImage(&bandRegisters[6], &image[6], 7);            // FMCHAN1 ~ CHAN_NUM1
+
+    kt09xx_fm_chan_0 fmchan0;
+    fmchan0.raw = image[5];
+    fmchan0.refined.CHANGE_BAND = 1;
+    return fmchan0.raw;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Copies the band registers held by the device (shadow register map) into an image
+ * @details Taken before seek, scanBand and sweep probe channels, so the band can be restored with 
+ * @details restoreBandRegisters.
+ * 
+ * @param image  receives BAND_REG_COUNT bytes, in the bandRegisters order
+ */
+void KT0937::saveBandRegisters(uint8_t *image)
+{
+    for (uint8_t i = 0; i < BAND_REG_COUNT; i++)
+        image[i] = getCachedRegister(bandRegisters[i]);
+}
+
+/**
+ * @ingroup GA03
+ * @brief Puts back the band registers saved with saveBandRegisters and sets CHANGE_BAND
+ * @details Unlike setChannel, the band is not narrowed: a radio tuned with the CH pin (see enableDialMode) 
+ * @details keeps its whole band. Only the registers that differ are written.
+ * 
+ * @param image  BAND_REG_COUNT bytes, in the bandRegisters order
+ */
+void KT0937::restoreBandRegisters(const uint8_t *image)
+{
+    kt09xx_fm_chan_0 fmchan0;
+
+    writeRegisterImage(bandRegisters, image, 5);                                 // BANDCFG0 ~ ADC4
+    writeRegisterImage(&bandRegisters[6], &image[6], BAND_REG_COUNT - 6);        // FMCHAN1 ~ GUARD2
+
+    fmchan0.raw = image[5];
+    fmchan0.refined.CHANGE_BAND = 1;
+    setRegister(REG_FMCHAN0, fmchan0.raw);
+}
+
+/**
+ * @ingroup GA03
+ * @brief Tunes a channel of the current mode (MCU tuning)
+ * @details The band is narrowed to the channel (see prepareChannel), then CHANGE_BAND is set (the timing policy 
+ * @details waits until the device clears it). The seek / scan range (the last band set with setBand) is kept.
+ * 
+ * @param channel  FM: frequency / 50kHz; MW/SW: frequency / 1kHz
+ */
+void KT0937::setChannel(uint16_t channel)
+{
+    KT0937LockGuard transaction(&this->configLock);
+
+    setRegister(REG_FMCHAN0, prepareChannel(channel));
+}
+
+/**
+ * @ingroup GA03
+ * @brief Sets the FM valid channel (VALID_TUNE) thresholds. FMTUNE_VALID0 ~ 1, one I2C transaction
+ * @details The thresholds are 3 bit codes, see kt09xx_fmtune_valid_0 and kt09xx_fmtune_valid_1. 
+ * @details E.g. snrLow 5 = 18, rssiLow 5 = -100dBm (power-on defaults).
+ * 
+ * @param snrLow    FM_TUN_SNR_LOWTH (0 ~ 7)
+ * @param snrHigh   FM_TUN_SNR_HITH (0 ~ 7)
+ * @param rssiLow   FM_TUN_RSSI_LOWTH (0 ~ 7). -110dBm + 2dB * rssiLow
+ * @param rssiHigh  FM_TUN_RSSI_HITH (0 ~ 7)
+ */
+void KT0937::setFMTuneValid(uint8_t snrLow, uint8_t snrHigh, uint8_t rssiLow, uint8_t rssiHigh)
+{
+    KT0937LockGuard transaction(&this->configLock);
+
+    uint8_t buf[2];
+    getCachedRegisters(REG_FMTUNE_VALID0, buf, 2);
+
+    kt09xx_fmtune_valid_0 reg0;
+    reg0.raw = buf[0];
+    reg0.refined.FM_TUN_SNR_LOWTH = snrLow;
+    reg0.refined.FM_TUN_SNR_HITH = snrHigh;
+    buf[0] = reg0.raw;
+
+    kt09xx_fmtune_valid_1 reg1;
+    reg1.raw = buf[1];
+    reg1.refined.FM_TUN_RSSI_LOWTH = rssiLow;
+    reg1.refined.FM_TUN_RSSI_HITH = rssiHigh;
+    buf[1] = reg1.raw;
+
+    writeRegisters(REG_FMTUNE_VALID0, buf, 2);
+}
+
+/**
+ * @ingroup GA03
+ * @brief Sets the MW valid channel (VALID_TUNE) thresholds. MWTUNE_VALID0 ~ 3, one I2C transaction
+ * 
+ * @param snrLow    MW_TUN_SNR_LOWTH (0 ~ 127)
+ * @param snrHigh   MW_TUN_SNR_HITH (0 ~ 127)
+ * @param rssiLow   MW_TUN_RSSI_LOWTH (0 ~ 127). Same units as AM_RSSI: dBm = rssiLow - 110
+ * @param rssiHigh  MW_TUN_RSSI_HITH (0 ~ 127)
+ */
+void KT0937::setMWTuneValid(uint8_t snrLow, uint8_t snrHigh, uint8_t rssiLow, uint8_t rssiHigh)
+{
+    KT0937LockGuard transaction(&this->configLock);
+
+    uint8_t buf[4];
+    getCachedRegisters(REG_MWTUNE_VALID0, buf, 4);
+
+    kt09xx_mwtune_valid_0 reg0;
+    reg0.raw = buf[0];
+    reg0.refined.MW_TUN_SNR_HITH = snrHigh;
+    buf[0] = reg0.raw;
+
+    kt09xx_mwtune_valid_1 reg1;
+    reg1.raw = buf[1];
+    reg1.refined.MW_TUN_SNR_LOWTH = snrLow;
+    buf[1] = reg1.raw;
+
+    kt09xx_mwtune_valid_2 reg2;
+    reg2.raw = buf[2];
+    reg2.refined.MW_TUN_RSSI_HITH = rssiHigh;
+    buf[2] = reg2.raw;
+
+    kt09xx_mwtune_valid_3 reg3;
+    reg3.raw = buf[3];
+    reg3.refined.MW_TUN_RSSI_LOWTH = rssiLow;
+    buf[3] = reg3.raw;
+
+    writeRegisters(REG_MWTUNE_VALID0, buf, 4);
+}
+
+/**
+ * @ingroup GA03
+ * @brief Sets the SW valid channel (VALID_TUNE) thresholds. SWTUNE_VALID0 ~ 3, one I2C transaction
+ * 
+ * @param snrLow    SW_TUN_SNR_LOWTH (0 ~ 127)
+ * @param snrHigh   SW_TUN_SNR_HITH (0 ~ 127)
+ * @param rssiLow   SW_TUN_RSSI_LOWTH (0 ~ 127). Same units as AM_RSSI: dBm = rssiLow - 110
+ * @param rssiHigh  SW_TUN_RSSI_HITH (0 ~ 127)
+ */
+void KT0937::setSWTuneValid(uint8_t snrLow, uint8_t snrHigh, uint8_t rssiLow, uint8_t rssiHigh)
+{
+    KT0937LockGuard transaction(&this->configLock);
+
+    uint8_t buf[4];
+    getCachedRegisters(REG_SWTUNE_VALID0, buf, 4);
+
+    kt09xx_sw_tune_valid_0 reg0;
+    reg0.raw = buf[0];
+    reg0.refined.SW_TUN_SNR_HITH = snrHigh;
+    buf[0] = reg0.raw;
+
+    kt09xx_sw_tune_valid_1 reg1;
+    reg1.raw = buf[1];
+    reg1.refined.SW_TUN_SNR_LOWTH = snrLow;
+    buf[1] = reg1.raw;
+
+    kt09xx_sw_tune_valid_2 reg2;
+    reg2.raw = buf[2];
+    reg2.refined.SW_TUN_RSSI_HITH = rssiHigh;
+    buf[2] = reg2.raw;
+
+    kt09xx_swtune_valid_3 reg3;
+    reg3.raw = buf[3];
+    reg3.refined.SW_TUN_RSSI_LOWTH = rssiLow;
+    buf[3] = reg3.raw;
+
+    writeRegisters(REG_SWTUNE_VALID0, buf, 4);
+}
+
+/**
+ * @ingroup GA03
+ * @brief Gets the RSSI low threshold of VALID_TUNE for the current band, in raw RSSI units (dBm + 110)
+ * @details Read from FMTUNE_VALID1, MWTUNE_VALID3 or SWTUNE_VALID3 (shadow register map).
+ */
+uint8_t KT0937::getSeekRSSIThreshold()
+{
+    if (this->currentMode == MODE_FM)
+    {
+        kt09xx_fmtune_valid_1 fm;
+        fm.raw = getCachedRegister(REG_FMTUNE_VALID1);
+        return fm.refined.FM_TUN_RSSI_LOWTH * 2;
+    }
+
+    kt09xx_bandcfg_0 bandcfg0;
+    bandcfg0.raw = getCachedRegister(REG_BANDCFG0);
+    if (bandcfg0.refined.SW_EN)
+    {
+        kt09xx_swtune_valid_3 sw;
+        sw.raw = getCachedRegister(REG_SWTUNE_VALID3);
+        return sw.refined.SW_TUN_RSSI_LOWTH;
+    }
+
+    kt09xx_mwtune_valid_3 mw;
+    mw.raw = getCachedRegister(REG_MWTUNE_VALID3);
+    return mw.refined.MW_TUN_RSSI_LOWTH;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Tunes a channel and checks if it holds a station
+ * @details Adaptive dwell: the status block is read once (one burst) SEEK_SETTLE_MS after the tuning. 
+ * @details A channel whose RSSI is more than SEEK_RSSI_MARGIN below the VALID_TUNE RSSI low threshold is 
+ * @details rejected at once. Otherwise, if VALID_TUNE is not set yet, it is given SEEK_DWELL_MS more and 
+ * @details the status block is read again.
+ * 
+ * @param channel  channel to be checked (RDCHAN units)
+ * @param station  receives the channel, RSSI and SNR
+ * @return true if VALID_TUNE is set
+ */
+bool KT0937::probeChannel(uint16_t channel, kt09xx_station &station)
+{
+    kt09xx_signal_status status;
+
+    setChannel(channel);
+    delay(SEEK_SETTLE_MS);
+    readStatus(status);
+
+    uint8_t rssi = (this->currentMode == MODE_FM) ? status.fmRSSI : status.amRSSI;
+    if (rssi + SEEK_RSSI_MARGIN < getSeekRSSIThreshold())
+        return false;
+
+    if (!status.valid)
+    {
+        delay(SEEK_DWELL_MS);
+        readStatus(status);
+    }
+
+    station.channel = channel;
+    station.rssi = (this->currentMode == MODE_FM) ? status.fmRSSI : status.amRSSI;
+    station.snr = (this->currentMode == MODE_FM) ? status.fmSNR : status.amSNR;
+    return status.valid;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Steps through the channels of the band until VALID_TUNE is set. Wraps around at the band edges
+ * @details If no channel is valid, the band registers held before the seek are restored (the starting channel 
+ * @details is tuned again) and errorCode is set to ERR_SEEK.
+ */
+bool KT0937::seek(uint8_t direction, kt09xx_station *station)
+{
+    uint16_t low = this->bandLowChannel;
+    uint16_t high = this->bandHighChannel;
+    uint16_t step = getChannelStep();
+
+    if (high <= low || step == 0)
+    {
+        this->errorCode = ERR_BAND_RANGE;
+        return false;
+    }
+
+    //align the starting channel on the channel grid of the band
+    high = low + ((high - low) / step) * step;
+    uint16_t start = getCurrentChannel();
+    if (start < low || start > high)
+        start = low;
+    start = low + ((start - low) / step) * step;
+
+    uint8_t saved[BAND_REG_COUNT];
+    saveBandRegisters(saved);
+
+    kt09xx_station found;
+    uint16_t channel = start;
+    uint16_t count = (high - low) / step;
+    for (uint16_t i = 0; i < count; i++)
+    {
+        if (direction == SEEK_UP)
+            channel = (channel >= high) ? low : channel + step;
+        else
+            channel = (channel <= low) ? high : channel - step;
+
+        if (probeChannel(channel, found))
+        {
+            if (station != NULL)
+                *station = found;
+            return true;
+        }
+    }
+
+    restoreBandRegisters(saved);
+    this->errorCode = ERR_SEEK;
+    return false;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Tunes the next valid channel (VALID_TUNE) above the current one
+ * @details The range is the last band set with setBand / setFMBand / setAMBand / setSWBand and the step 
+ * @details its channel space. Each channel costs one status burst, plus a second one only when its RSSI is 
+ * @details close to the threshold (see probeChannel). The thresholds are set with setFMTuneValid, 
+ * @details setMWTuneValid and setSWTuneValid.
+ * 
+ * @param station  if not NULL, receives the channel, RSSI and SNR of the station found
+ * @return true if a station was found; false otherwise (errorCode = ERR_SEEK, the starting channel is tuned)
+ */
+bool KT0937::seekUp(kt09xx_station *station)
+{
+    KT0937LockGuard transaction(&this->configLock);
+
+    return seek(SEEK_UP, station);
+}
+
+/**
+ * @ingroup GA03
+ * @brief Tunes the next valid channel (VALID_TUNE) below the current one
+ * @see seekUp
+ */
+bool KT0937::seekDown(kt09xx_station *station)
+{
+    KT0937LockGuard transaction(&this->configLock);
+
+    return seek(SEEK_DOWN, station);
+}
+
+/**
+ * @ingroup GA03
+ * @brief Scans the whole band and lists the valid channels (VALID_TUNE), sorted by channel
+ * @details When more than maxStations are found, the weakest ones are dropped. At the end the band registers 
+ * @details held before the scan are restored (see restoreBandRegisters): the channel tuned before the scan is 
+ * @details tuned again, or the whole band for a radio tuned with the CH pin. See seekUp for the range, step 
+ * @details and cost per channel.
+ * 
+ * @param stations     receives the stations, lowest channel first
+ * @param maxStations  size of stations
+ * @return number of stations listed
+ */
+uint8_t KT0937::scanBand(kt09xx_station *stations, uint8_t maxStations)
+{
+    KT0937LockGuard transaction(&this->configLock);
+
+    uint16_t low = this->bandLowChannel;
+    uint16_t high = this->bandHighChannel;
+    uint16_t step = getChannelStep();
+
+    if (high <= low || step == 0)
+    {
+        this->errorCode = ERR_BAND_RANGE;
+        return 0;
+    }
+
+    uint8_t saved[BAND_REG_COUNT];
+    uint8_t count = 0;
+    kt09xx_station found;
+
+    saveBandRegisters(saved);
+
+    for (uint16_t channel = low; channel <= high; channel += step)
+    {
+        if (!probeChannel(channel, found))
+            continue;
+
+        if (count < maxStations)
+        {
+            stations[count++] = found;
+            continue;
+        }
+
+        //list full: drop the weakest station if the new one is stronger
+        uint8_t weakest = 0;
+        for (uint8_t i = 1; i < count; i++)
+            if (stations[i].rssi < stations[weakest].rssi)
+                weakest = i;
+        if (count == 0 || found.rssi <= stations[weakest].rssi)
+            continue;
+        memmove(&stations[weakest], &stations[weakest + 1], (count - weakest - 1) * sizeof(kt09xx_station));
+        stations[count - 1] = found;
+    }
+
+    restoreBandRegisters(saved);
+    return count;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Reads the RSSI (and SNR) of the current channel with the smallest burst
+ * @details FM: STATUS8 alone, or STATUS4 ~ STATUS8. MW/SW: AMSTATUS0 alone, or AMSTATUS0 ~ AMSTATUS2.
+ */
+void KT0937::readSweepSample(uint8_t *rssi, uint8_t *snr)
+{
+    uint8_t buf[REG_STATUS8 - REG_STATUS4 + 1];
+
+    if (this->currentMode == MODE_FM)
+    {
+        kt09xx_status_8 st8;
+        kt09xx_status_4 st4;
+        if (snr == NULL)
+        {
+            st8.raw = getRegister(REG_STATUS8);
+        }
+        else
+        {
+            readRegisters(REG_STATUS4, buf, REG_STATUS8 - REG_STATUS4 + 1);
+            st4.raw = buf[0];
+            st8.raw = buf[REG_STATUS8 - REG_STATUS4];
+            *snr = st4.refined.FM_SNR;
+        }
+        *rssi = st8.refined.FM_RSSI;
+        return;
+    }
+
+    kt09xx_am_status_0 am0;
+    kt09xx_am_status_2 am2;
+    if (snr == NULL)
+    {
+        am0.raw = getRegister(REG_AMSTATUS0);
+    }
+    else
+    {
+        readRegisters(REG_AMSTATUS0, buf, REG_AMSTATUS2 - REG_AMSTATUS0 + 1);
+        am0.raw = buf[0];
+        am2.raw = buf[REG_AMSTATUS2 - REG_AMSTATUS0];
+        *snr = am2.refined.AM_SNR_MODE1;
+    }
+    *rssi = am0.refined.AM_RSSI;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Spectrum sweep: RSSI (and SNR) of count channels from lowChannel, step apart
+ * @details Uses the band registers of the current band (mode, SW_EN, space...): only the channel changes, 
+ * @details see prepareChannel. Each channel is tuned with a CHANGE_BAND write that still waits for the 
+ * @details device to clear the bit. Only the LOW_CHAN / HIGH_CHAN writes of channel N + 1 overlap the 
+ * @details settling time of channel N (SWEEP_SETTLE_US); then the sample of channel N is read (1 byte, or 
+ * @details 3 ~ 5 bytes with SNR). At the end the band registers held before the sweep are restored (see 
+ * @details restoreBandRegisters), so a radio tuned with the CH pin keeps its band. 
+ * @details Use setI2CBus(Wire, I2C_CLOCK_400KHZ) for the fastest sweep.
+ * 
+ * @param lowChannel  first channel (RDCHAN units. FM: 50kHz; MW/SW: 1kHz)
+ * @param step        channel step (RDCHAN units)
+ * @param count       number of channels. rssi (and snr) hold count bytes
+ * @param rssi        receives the raw RSSI of each channel (dBm = rssi - 110)
+ * @param snr         receives the raw SNR of each channel. NULL = RSSI only (faster)
+ */
+void KT0937::sweep(uint16_t lowChannel, uint16_t step, uint16_t count, uint8_t *rssi, uint8_t *snr)
+{
+    KT0937LockGuard transaction(&this->configLock);
+
+    if (count == 0)
+        return;
+
+    uint8_t saved[BAND_REG_COUNT];
+    saveBandRegisters(saved);
+    uint8_t fmchan0 = prepareChannel(lowChannel);
+
+    for (uint16_t i = 0; i < count; i++)
+    {
+        setRegister(REG_FMCHAN0, fmchan0);          // tunes channel i. Waits for CHANGE_BAND cleared
+        uint32_t tuned = micros();
+
+        if (i + 1 < count)
+            fmchan0 = prepareChannel(lowChannel + (i + 1) * step);
+
+        uint32_t elapsed = micros() - tuned;
+        if (elapsed < SWEEP_SETTLE_US)
+            delayMicroseconds(SWEEP_SETTLE_US - elapsed);
+
+        readSweepSample(&rssi[i], (snr != NULL) ? &snr[i] : NULL);
+    }
+
+    restoreBandRegisters(saved);
+}
+
+/**
+ * @ingroup GA03
+ * @brief Spectrum sweep of the whole current band (the last band set with setBand / setSWBand...)
+ * @details E.g. after setSWBand(9400, 9900, 500): 501 samples, 1kHz apart. See sweep.
+ * 
+ * @param rssi        receives the raw RSSI of each channel
+ * @param snr         receives the raw SNR of each channel. NULL = RSSI only
+ * @param maxSamples  size of rssi (and snr). The sweep stops there
+ * @return number of samples
+ */
+uint16_t KT0937::sweepBand(uint8_t *rssi, uint8_t *snr, uint16_t maxSamples)
+{
+    KT0937LockGuard transaction(&this->configLock);
+
+    uint16_t step = getChannelStep();
+
+    if (this->bandHighChannel <= this->bandLowChannel || step == 0)
+    {
+        this->errorCode = ERR_BAND_RANGE;
+        return 0;
+    }
+
+    uint16_t count = (this->bandHighChannel - this->bandLowChannel) / step + 1;
+    if (count > maxSamples)
+        count = maxSamples;
+    sweep(this->bandLowChannel, step, count, rssi, snr);
+    return count;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Gets the current station as a station memory entry. See KT0937StationStore
+ * @details STATION_FLAG_CHANNEL is set when the channel was tuned by the MCU (setChannel, seek...). 
+ * 
+ * @param band   band id of the application (stored as is)
+ * @param entry  receives the band id, the current channel (one I2C read), the volume and the flags
+ */
+void KT0937::getStationEntry(uint8_t band, kt09xx_station_entry &entry)
+{
+    KT0937LockGuard transaction(&this->configLock);
+
+    kt09xx_chan_num_0 num0;
+    num0.raw = getCachedRegister(REG_CHAN_NUM0);
+
+    entry.band = band;
+    entry.channel = getCurrentChannel();
+    entry.volume = this->currentVolume;
+    entry.flags = (num0.refined.CHAN_NUM_11_8 == 0 && getCachedRegister(REG_CHAN_NUM1) == 0) ? STATION_FLAG_CHANNEL : 0;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Restores a station memory entry in one batch
+ * @details With STATION_FLAG_CHANNEL the band image is narrowed to the stored channel before it is applied, 
+ * @details so the band and the channel cost a single band switch (one CHANGE_BAND, only the registers that 
+ * @details differ are written), followed by the volume. The seek / scan range is the whole band.
+ * 
+ * @param bandImage  band register image of entry.band (see getBandImage)
+ * @param entry      station to restore
+ */
+void KT0937::applyStation(const kt09xx_band_image &bandImage, const kt09xx_station_entry &entry)
+{
+    KT0937LockGuard transaction(&this->configLock);
+
+    kt09xx_band_image image = bandImage;
+
+    if (entry.flags & STATION_FLAG_CHANNEL)
+    {
+        kt09xx_fm_chan_0 fmchan0;
+        fmchan0.raw = image.reg[5];
+        setCurrentMode(fmchan0.refined.AM_FM);
+        setBandRange(image.reg);
+        setImageChannel(image.reg, entry.channel, fmchan0.refined.AM_FM);
+    }
+
+    setBand(image);
+    setVolume(entry.volume);
+}
+
+ void KT0937::enableDialMode()
+ {
+    KT0937LockGuard transaction(&this->configLock);
+
+    //set CH_PIN<1:0> to  10
+    kt09xx_gpiocfg_2 reg ;
+    reg.raw = getCachedRegister(REG_GPIOCFG2);
+    reg.refined.CH_PIN = 2;
+    setRegister(REG_GPIOCFG2,reg.raw);
+ }
+
+ void KT0937::disableFMSoftMute(bool disable)
+ {
+    KT0937LockGuard transaction(&this->configLock);
+
+    kt09xx_mutecfg_0 reg;
+    reg.raw = getCachedRegister(REG_MUTECFG0);
+    reg.refined.FM_DSMUTE = disable;
+    setRegister(REG_MUTECFG0,reg.raw);
+ }
+
+ void KT0937::disableMWSoftMute(bool disable)
+ {
+    KT0937LockGuard transaction(&this->configLock);
+
+    kt09xx_mutecfg_0 reg;
+    reg.raw = getCachedRegister(REG_MUTECFG0);
+    reg.refined.MW_DSMUTE = disable;
+    setRegister(REG_MUTECFG0,reg.raw);
+ }
+
+ void KT0937::disableSWSoftMute(bool disable)
+ {
+    KT0937LockGuard transaction(&this->configLock);
+
+    kt09xx_sw_softmute_0 reg;
+    reg.raw = getCachedRegister(REG_SW_SOFTMUTE0);
+    reg.refined.SW_DSMUTE = disable;
+    setRegister(REG_SW_SOFTMUTE0,reg.raw);
+ }
+
+ void KT0937::disableMWAFC(bool disable)
+ {
+    KT0937LockGuard transaction(&this->configLock);
+
+    kt09xx_afc_3 reg;
+    reg.raw = getCachedRegister(REG_AFC3);
+    reg.refined.MW_AFCD = disable;
+    setRegister(REG_AFC3,reg.raw);
+ }
+
+ 
+
+//disable FM AFC
+void KT0937::disableFMAFC(bool disable)
+ {
+    KT0937LockGuard transaction(&this->configLock);
+
+    kt09xx_afc_2 reg;
+    reg.raw = getCachedRegister(REG_AFC2);
+    reg.refined.FM_AFCD = disable;
+    setRegister(REG_AFC2,reg.raw);
+ }
+
+ //disable SW AFC
+void KT0937::disableSWAFC(bool disable)
+ {
+    KT0937LockGuard transaction(&this->configLock);
+
+    kt09xx_swcfg_0 reg;
+    reg.raw = getCachedRegister(REG_SW_CFG0);
+    reg.refined.SW_AFCD = disable;
+    setRegister(REG_SW_CFG0,reg.raw);
+ }
+
+
+ /* 
+ * mwIFBW   000 : 1.2kHz
+ *          001 : 2.4kHz
+ *          010 : 3.6kHz
+ *          011 : 4.8KHz
+            100 : 6.0KHz
+ *
+ */
+ 
+ void KT0937::setAMIFBW(uint8_t mwIFBW)
+ {
+    KT0937LockGuard transaction(&this->configLock);
+
+    kt09xx_amdsp_0 reg;
+    reg.raw = getCachedRegister(REG_AMDSP0);
+    reg.refined.FLT_SEL = mwIFBW;
+    setRegister(REG_AMDSP0,reg.raw);
+ }
+
+/**
+ * @ingroup GA03
+ * @brief Gets the current channel (RDCHAN<14:0>)
+ * @details RDCHAN_14_8 (STATUS6) and RDCHAN_7_0 (STATUS7) are read in the same I2C transaction, so both 
+ * @details bytes belong to the same channel even while the dial is turning.
+ * @return FM: frequency / 50kHz; MW/SW: frequency / 1kHz
+ */
+ uint16_t KT0937::getCurrentChannel()
+ {
+    uint8_t buf[2];
+    readRegisters(REG_STATUS6, buf, 2);
+    kt09xx_status_6 regH;
+    regH.raw = buf[0];
+    kt09xx_status_7 regL;
+    regL.raw = buf[1];
+    this->currentFrequency = ((uint16_t) regH.refined.RDCHAN_14_8 << 8) | regL.refined.RDCHAN_7_0;
+    return this->currentFrequency;
+ }
+
+/**
+ * @ingroup GA03
+ * @brief Gets the current channel
+ * @details Kept for compatibility. Same as getCurrentChannel.
+ * @see getCurrentFrequencyKHz
+ * @return FM: frequency / 50kHz; MW/SW: frequency / 1kHz
+ */
+ uint16_t KT0937::getCurrentFrequency()
+ {
+    return getCurrentChannel();
+ }
+
+/**
+ * @ingroup GA03
+ * @brief Gets the current frequency in kHz for the current mode
+ * @details FM channels are 50kHz units, MW/SW channels are 1kHz units.
+ * @return frequency in kHz. E.g. 98100 (98.1MHz FM), 1008 (MW), 9650 (SW)
+ */
+ uint32_t KT0937::getCurrentFrequencyKHz()
+ {
+    uint32_t channel = getCurrentChannel();
+    return (readCurrentMode() == MODE_FM) ? channel * FM_CHANNEL_KHZ : channel * AM_CHANNEL_KHZ;
+ }
+
+/**
+ * @ingroup GA03
+ * @brief Gets the current frequency in Hz for the current mode
+ * @return frequency in Hz
+ */
+ uint32_t KT0937::getCurrentFrequencyHz()
+ {
+    return getCurrentFrequencyKHz() * 1000UL;
+ }
+
+
+ uint8_t KT0937::getAMRSSI()
+{   
+    kt09xx_am_status_0 reg;
+    reg.raw = getRegister(REG_AMSTATUS0);
+    this->currentAMRSSI = reg.refined.AM_RSSI + RSSI_DBUVEMF_OFFSET;  //dBuVEMF. See convertRSSI
+    recordSignal(MODE_AM, SIGNAL_RSSI, this->currentAMRSSI);
+    return this->currentAMRSSI;
+}
+
+uint8_t KT0937::getAMSNR()
 {   
     kt09xx_am_status_2 reg;
     reg.raw = getRegister(REG_AMSTATUS2);
     this->currentAMSNR = reg.refined.AM_SNR_MODE1;  // 0 minimum , 63 maximum
+    recordSignal(MODE_AM, SIGNAL_SNR, this->currentAMSNR);
     return this->currentAMSNR;
 }
 
-uint8_t KT0937::getFMRSSI()
-{   
-    kt09xx_status_8 reg;
-    reg.raw = getRegister(REG_STATUS8);
-    this->currentFMRSSI = reg.refined.FM_RSSI + 3;  //dBm = RSSI -110 ; dBuV = RSSI - 3; dBuVEMF = RSSI + 3; 
-    return this->currentFMRSSI;
+uint8_t KT0937::getFMRSSI()
+{   
+    kt09xx_status_8 reg;
+    reg.raw = getRegister(REG_STATUS8);
+    this->currentFMRSSI = reg.refined.FM_RSSI + RSSI_DBUVEMF_OFFSET;  //dBuVEMF. See convertRSSI
+    recordSignal(MODE_FM, SIGNAL_RSSI, this->currentFMRSSI);
+    return this->currentFMRSSI;
+}
+
+uint8_t KT0937::getFMSNR()
+{   
+    kt09xx_status_4 reg;
+    reg.raw = getRegister(REG_STATUS4);
+    this->currentFMSNR = reg.refined.FM_SNR;  // 0 minimum , 63 maximum
+    recordSignal(MODE_FM, SIGNAL_SNR, this->currentFMSNR);
+    return this->currentFMSNR;
+}
+
+uint8_t KT0937::getRSSI()
+{
+    uint8_t mode = readCurrentMode();
+    if(mode == MODE_AM)
+    {
+        this->currentRSSI = this->getAMRSSI();
+    }else if( mode == MODE_FM)
+    {
+        this->currentRSSI = this->getFMRSSI();
+    }
+    return(this->currentRSSI);
+}
+
+uint8_t KT0937::getSNR()
+{
+    uint8_t mode = readCurrentMode();
+    if(mode == MODE_AM)
+    {
+        this->currentSNR = this->getAMSNR();
+    }else if( mode == MODE_FM)
+    {
+        this->currentSNR = this->getFMSNR();
+    }
+    return(this->currentSNR);
+
+}
+
+/**
+ * @ingroup GA03
+ * @brief Reads RSSI, SNR, stereo, valid channel, AFC offsets, softmute gain and channel at once
+ * @details The whole status block STATUS0 ~ AMSTATUS3 (0xDE ~ 0xED) is read in one I2C transaction.
+ * @details currentRSSI, currentSNR and the other values returned by the single getters are refreshed too.
+ * 
+ * @param status  receives the snapshot
+ */
+void KT0937::readStatus(kt09xx_signal_status &status)
+{
+    uint8_t buf[REG_AMSTATUS3 - REG_STATUS0 + 1];
+    readRegisters(REG_STATUS0, buf, sizeof(buf));
+
+    kt09xx_status_0 st0;
+    st0.raw = buf[REG_STATUS0 - REG_STATUS0];
+    kt09xx_status_4 st4;
+    st4.raw = buf[REG_STATUS4 - REG_STATUS0];
+    kt09xx_status_5 st5;
+    st5.raw = buf[REG_STATUS5 - REG_STATUS0];
+    kt09xx_status_6 st6;
+    st6.raw = buf[REG_STATUS6 - REG_STATUS0];
+    kt09xx_status_7 st7;
+    st7.raw = buf[REG_STATUS7 - REG_STATUS0];
+    kt09xx_status_8 st8;
+    st8.raw = buf[REG_STATUS8 - REG_STATUS0];
+    kt09xx_afc_status_0 afc0;
+    afc0.raw = buf[REG_AFC_STATUS0 - REG_STATUS0];
+    kt09xx_afc_status_1 afc1;
+    afc1.raw = buf[REG_AFC_STATUS1 - REG_STATUS0];
+    kt09xx_am_status_0 am0;
+    am0.raw = buf[REG_AMSTATUS0 - REG_STATUS0];
+    kt09xx_am_status_2 am2;
+    am2.raw = buf[REG_AMSTATUS2 - REG_STATUS0];
+    kt09xx_am_status_3 am3;
+    am3.raw = buf[REG_AMSTATUS3 - REG_STATUS0];
+
+    status.channel = ((uint16_t) st6.refined.RDCHAN_14_8 << 8) | st7.refined.RDCHAN_7_0;
+    status.fmRSSI = st8.refined.FM_RSSI;
+    status.fmSNR = st4.refined.FM_SNR;
+    status.amRSSI = am0.refined.AM_RSSI;
+    status.amSNR = am2.refined.AM_SNR_MODE1;
+    status.smuteGain = st5.refined.SMUTE_GAIN;
+    status.fmCarrierOffset = (int8_t) afc1.refined.FM_CARRIER_OFST;
+    status.amCarrierOffset = (int8_t) afc0.refined.AM_CARRIER_OFST;
+    status.stereo = st0.refined.ST_TUNE;
+    status.valid = st0.refined.VALID_TUNE;
+    status.amCarrierLock = am3.refined.AM_CARRY_LOCK;
+    status.reserved = 0;
+
+    KT0937LockGuard bus(&this->busLock);
+    this->currentFrequency = status.channel;
+    this->currentFMRSSI = status.fmRSSI + RSSI_DBUVEMF_OFFSET;    //dBuVEMF, as getFMRSSI
+    this->currentFMSNR = status.fmSNR;
+    this->currentAMRSSI = status.amRSSI + RSSI_DBUVEMF_OFFSET;    //as getAMRSSI
+    this->currentAMSNR = status.amSNR;
+    this->currentRSSI = (this->currentMode == MODE_AM) ? this->currentAMRSSI : this->currentFMRSSI;
+    this->currentSNR = (this->currentMode == MODE_AM) ? this->currentAMSNR : this->currentFMSNR;
+    recordSignal(this->currentMode, SIGNAL_RSSI, this->currentRSSI);
+    recordSignal(this->currentMode, SIGNAL_SNR, this->currentSNR);
+}
+
+/**
+ * @ingroup GA03
+ * @brief Adds a sample to the history of a metric and updates its moving average
+ * @details The histories are cleared first if the channel has changed since the last sample.
+ * 
+ * @param mode    MODE_FM or MODE_AM
+ * @param metric  SIGNAL_RSSI or SIGNAL_SNR
+ * @param value   sample, as returned by the getter
+ */
+void KT0937::recordSignal(uint8_t mode, uint8_t metric, uint8_t value)
+{
+    KT0937LockGuard bus(&this->busLock);
+
+    if (this->signalHistoryStale)
+    {
+        this->signalHistoryStale = false;
+        memset(this->signalHistory, 0, sizeof(this->signalHistory));
+    }
+
+    kt09xx_signal_history *h = &this->signalHistory[mode & 1][metric & 1];
+    h->sample[h->head] = value;
+    h->head = (h->head + 1) % KT0937_HISTORY_SIZE;
+    if (h->count < KT0937_HISTORY_SIZE)
+        h->count++;
+
+    //ema += (sample - ema) / 2^SIGNAL_EMA_SHIFT, in 8.8 fixed point. The first sample starts the average
+    uint16_t sample = (uint16_t) value << 8;
+    if (h->count == 1)
+        h->ema = sample;
+    else if (sample >= h->ema)
+        h->ema += (sample - h->ema) >> SIGNAL_EMA_SHIFT;
+    else
+        h->ema -= (h->ema - sample) >> SIGNAL_EMA_SHIFT;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Gets the statistics of the sample history of a metric. No bus access
+ * @details The history is fed by getRSSI, getSNR, getFMRSSI, getFMSNR, getAMRSSI, getAMSNR and readStatus 
+ * @details (so by pollTelemetry too), and cleared when the channel changes.
+ * 
+ * @param mode    MODE_FM or MODE_AM
+ * @param metric  SIGNAL_RSSI or SIGNAL_SNR
+ * @param stats   receives last, min, max, mean, median, ema and count
+ * @return false if the history is empty (stats set to 0)
+ */
+bool KT0937::getSignalStats(uint8_t mode, uint8_t metric, kt09xx_signal_stats &stats)
+{
+    KT0937LockGuard bus(&this->busLock);
+
+    const kt09xx_signal_history *h = &this->signalHistory[mode & 1][metric & 1];
+    memset(&stats, 0, sizeof(stats));
+    if (this->signalHistoryStale || h->count == 0)
+        return false;
+
+    //insertion sort of a copy, for the median
+    uint8_t sorted[KT0937_HISTORY_SIZE];
+    uint16_t sum = 0;
+    stats.min = 0xFF;
+    for (uint8_t i = 0; i < h->count; i++)
+    {
+        uint8_t v = h->sample[i];
+        sum += v;
+        if (v < stats.min)
+            stats.min = v;
+        if (v > stats.max)
+            stats.max = v;
+
+        uint8_t j = i;
+        for (; j > 0 && sorted[j - 1] > v; j--)
+            sorted[j] = sorted[j - 1];
+        sorted[j] = v;
+    }
+
+    uint8_t middle = h->count / 2;
+    stats.median = (h->count & 1) ? sorted[middle] : (sorted[middle - 1] + sorted[middle] + 1) / 2;
+    stats.mean = (sum + h->count / 2) / h->count;
+    stats.ema = (h->ema + 0x80) >> 8;
+    stats.last = h->sample[(h->head + KT0937_HISTORY_SIZE - 1) % KT0937_HISTORY_SIZE];
+    stats.count = h->count;
+    return true;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Discards the RSSI and SNR histories of both modes
+ */
+void KT0937::clearSignalHistory()
+{
+    KT0937LockGuard bus(&this->busLock);
+
+    memset(this->signalHistory, 0, sizeof(this->signalHistory));
+    this->signalHistoryStale = false;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Reads the RSSI of the current mode (see getRSSI) and returns its exponential moving average
+ * @return dBuVEMF, smoothed over about 2^SIGNAL_EMA_SHIFT samples
+ */
+uint8_t KT0937::getFilteredRSSI()
+{
+    kt09xx_signal_stats stats;
+    getRSSI();
+    getSignalStats(this->currentMode, SIGNAL_RSSI, stats);
+    return stats.ema;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Reads the SNR of the current mode (see getSNR) and returns its exponential moving average
+ */
+uint8_t KT0937::getFilteredSNR()
+{
+    kt09xx_signal_stats stats;
+    getSNR();
+    getSignalStats(this->currentMode, SIGNAL_SNR, stats);
+    return stats.ema;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Reads the RSSI of the current mode (see getRSSI) and returns the median of the history
+ * @details Ignores isolated spikes, unlike the moving average.
+ * @return dBuVEMF
+ */
+uint8_t KT0937::getMedianRSSI()
+{
+    kt09xx_signal_stats stats;
+    getRSSI();
+    getSignalStats(this->currentMode, SIGNAL_RSSI, stats);
+    return stats.median;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Reads the SNR of the current mode (see getSNR) and returns the median of the history
+ */
+uint8_t KT0937::getMedianSNR()
+{
+    kt09xx_signal_stats stats;
+    getSNR();
+    getSignalStats(this->currentMode, SIGNAL_SNR, stats);
+    return stats.median;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Receiver path of the current band
+ * @return CALIBRATION_FM, CALIBRATION_MW or CALIBRATION_SW
+ */
+uint8_t KT0937::getCalibrationBand()
+{
+    kt09xx_bandcfg_0 bandcfg0;
+    if (this->currentMode == MODE_FM)
+        return CALIBRATION_FM;
+    bandcfg0.raw = getCachedRegister(REG_BANDCFG0);
+    return bandcfg0.refined.SW_EN ? CALIBRATION_SW : CALIBRATION_MW;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Programs the RSSI bias of a receiver path into FM_RSSI_BIAS (DSPCFG6) or AM_RSSI_BIAS (AMDSP1)
+ * @details Nothing is written until setRSSIBias has been called, or if the register already holds the bias. 
+ * @details MW and SW share AM_RSSI_BIAS: the band switch programs the one of the new band.
+ * 
+ * @param calibrationBand  CALIBRATION_FM, CALIBRATION_MW or CALIBRATION_SW
+ */
+void KT0937::applyRSSIBias(uint8_t calibrationBand)
+{
+    if (!this->rssiBiasEnabled || calibrationBand >= CALIBRATION_BAND_COUNT)
+        return;
+
+    int reg = (calibrationBand == CALIBRATION_FM) ? REG_DSPCFG6 : REG_AMDSP1;
+    uint8_t value = (getCachedRegister(reg) & ~RSSI_BIAS_MASK) | ((uint8_t) this->rssiBias[calibrationBand] & RSSI_BIAS_MASK);
+    if (!isShadowEqual(reg, value))
+        setRegister(reg, value);
+}
+
+/**
+ * @ingroup GA03
+ * @brief Sets the RSSI bias of a receiver path
+ * @details The device adds the bias to every RSSI it measures on that path, so getRSSI, readStatus, the 
+ * @details valid station detection and seek all use the corrected level. The bias is programmed at once if 
+ * @details the path is the current one, and at each band switch (setBand, queueBand...) otherwise.
+ * @details Until this method is called the library leaves FM_RSSI_BIAS and AM_RSSI_BIAS untouched.
+ * 
+ * @param calibrationBand  CALIBRATION_FM, CALIBRATION_MW or CALIBRATION_SW
+ * @param bias             dB, RSSI_BIAS_MIN (-16) ~ RSSI_BIAS_MAX (15). Values out of range are clamped
+ */
+void KT0937::setRSSIBias(uint8_t calibrationBand, int8_t bias)
+{
+    KT0937LockGuard transaction(&this->configLock);
+
+    if (calibrationBand >= CALIBRATION_BAND_COUNT)
+        return;
+    if (bias < RSSI_BIAS_MIN)
+        bias = RSSI_BIAS_MIN;
+    else if (bias > RSSI_BIAS_MAX)
+        bias = RSSI_BIAS_MAX;
+
+    this->rssiBias[calibrationBand] = bias;
+    this->rssiBiasEnabled = true;
+    if (calibrationBand == getCalibrationBand())
+        applyRSSIBias(calibrationBand);
+}
+
+/**
+ * @ingroup GA03
+ * @brief Gets the RSSI bias of a receiver path (see setRSSIBias)
+ * @param calibrationBand  CALIBRATION_FM, CALIBRATION_MW or CALIBRATION_SW
+ * @return dB
+ */
+int8_t KT0937::getRSSIBias(uint8_t calibrationBand)
+{
+    return (calibrationBand < CALIBRATION_BAND_COUNT) ? this->rssiBias[calibrationBand] : 0;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Converts a raw RSSI register value (FM_RSSI, AM_RSSI) to a signal level
+ * @param rssi  raw RSSI, as in kt09xx_signal_status
+ * @param unit  RSSI_UNIT_DBUVEMF, RSSI_UNIT_DBUV or RSSI_UNIT_DBM
+ * @return level in the given unit
+ */
+int16_t KT0937::convertRSSI(uint8_t rssi, uint8_t unit)
+{
+    switch (unit)
+    {
+    case RSSI_UNIT_DBUV:
+        return (int16_t) rssi + RSSI_DBUV_OFFSET;
+    case RSSI_UNIT_DBM:
+        return (int16_t) rssi + RSSI_DBM_OFFSET;
+    default:
+        return (int16_t) rssi + RSSI_DBUVEMF_OFFSET;
+    }
+}
+
+/**
+ * @ingroup GA03
+ * @brief Reads the RSSI of the current mode (see getRSSI) in a given unit
+ * @param unit  RSSI_UNIT_DBUVEMF, RSSI_UNIT_DBUV or RSSI_UNIT_DBM
+ * @return signed level, e.g. -87 (dBm)
+ */
+int16_t KT0937::getRSSILevel(uint8_t unit)
+{
+    return convertRSSI(getRSSI() - RSSI_DBUVEMF_OFFSET, unit);
+}
+
+/**
+ * @ingroup GA03
+ * @brief Derives the RSSI bias of the current receiver path from a known reference level
+ * @details Tune a generator (or a station of known strength) first. The RSSI is averaged over samples 
+ * @details readings, CALIBRATION_SAMPLE_MS apart, and the bias is corrected by the difference between the 
+ * @details reference and the measured level, then stored and programmed like setRSSIBias. Read it back with 
+ * @details getRSSIBias to keep it in non-volatile memory.
+ * @details If the correction does not fit in RSSI_BIAS_MIN ~ RSSI_BIAS_MAX, the bias is clamped and errorCode 
+ * @details is set to ERR_CALIBRATION.
+ * 
+ * @param referenceLevel  level of the reference signal at the antenna input
+ * @param unit            unit of referenceLevel: RSSI_UNIT_DBUVEMF, RSSI_UNIT_DBUV or RSSI_UNIT_DBM
+ * @param samples         number of RSSI readings averaged (1 ~ 255)
+ * @return true if the bias is within range
+ */
+bool KT0937::calibrateRSSI(int16_t referenceLevel, uint8_t unit, uint8_t samples)
+{
+    KT0937LockGuard transaction(&this->configLock);
+
+    uint8_t calibrationBand = getCalibrationBand();
+    int reg = (calibrationBand == CALIBRATION_FM) ? REG_DSPCFG6 : REG_AMDSP1;
+    uint16_t sum = 0;
+
+    if (samples == 0)
+        samples = 1;
+    for (uint8_t i = 0; i < samples; i++)
+    {
+        if (i)
+            delay(CALIBRATION_SAMPLE_MS);
+        sum += getRSSI() - RSSI_DBUVEMF_OFFSET;
+    }
+
+    // the reading already includes the bias held by the device
+    int8_t current = (int8_t) (getCachedRegister(reg) << 3) >> 3;
+    int16_t measured = convertRSSI((sum + samples / 2) / samples, unit);
+    int16_t bias = current + (referenceLevel - measured);
+    bool inRange = (bias >= RSSI_BIAS_MIN && bias <= RSSI_BIAS_MAX);
+
+    setRSSIBias(calibrationBand, (int8_t) ((bias < RSSI_BIAS_MIN) ? RSSI_BIAS_MIN : (bias > RSSI_BIAS_MAX) ? RSSI_BIAS_MAX : bias));
+    if (!inRange)
+        this->errorCode = ERR_CALIBRATION;
+    return inRange;
+}
+
+/**
+ * @ingroup GA03
+ * @brief 
+ *    Register TUNE_INT_EN is used to enable the interrupt. When TUNE_INT_EN=1, the change of CH pin 
+ *voltage will lead to the interrupt signal of INT pin. When TUNE_INT_EN=0, whether CH pin voltage 
+ *changes or not, the INT pin will not output the interrupt signal. 
+ *
+ *   Register TUNE_INT_MODE is used to select the mode of interrupt. When TUNE_INT_MODE=1, 
+ *KT0937 will output the pulse interrupt signal. When TUNE_INT_MODE=0, KT0937 will output the level 
+ *interrupt signal.
+ *  Register TUNE_INT_PL is used to set the polarity of the interrupt signal while tuning. When 
+ *TUNE_INT_PL=0, the output of interrupt is low level or negative pulse signal. When TUNE_INT_PL=1, 
+ *the output of interrupt is high level or positive pulse signal.
+ *   There is no need to clear the interrupt in MCU when it shows the pulse signal, KT0937 can do it 
+ *automatically. But if there is a low level signal showed, just set INT_PIN<1:0> in 2b’01 to clear the 
+ *interrupt output. And as the case of high level signal, INT_PIN<1:0> should be set in 2b’10 to clear the 
+ *interrupt output.
+ * 
+ * @see enable INT mode
+ * 
+ * @param 
+ * 
+ */
+
+void KT0937::setIntMode(bool isRising)
+{
+    KT0937LockGuard transaction(&this->configLock);
+
+    kt09xx_softmute_5 reg0;
+    kt09xx_softmute_2 reg1;
+    
+   
+    // set Pulse mode :  positive Pulse (RISING): TUNE_INT_MODE : 0x22<6> = 1, TUNE_INT_PL:0x1F<7> = 1 
+    //                   negtive Pulse (FALLING): TUNE_INT_MODE : 0x22<6> = 1, TUNE_INT_PL:0x1F<7> = 0
+
+    if(isRising == INT_MODE_RISING)
+    {        
+        reg0.raw = getCachedRegister(REG_SOFTMUTE5);
+        reg0.refined.TUNE_INT_MODE= 1;        
+        setRegister(REG_SOFTMUTE5,reg0.raw);
+
+        reg1.raw = getCachedRegister(REG_SOFTMUTE2);
+        reg1.refined.TUNE_INT_PL= 1;
+        setRegister(REG_SOFTMUTE2,reg1.raw);
+
+    }else if(isRising == INT_MODE_FALLING)
+    {
+        reg0.raw = getCachedRegister(REG_SOFTMUTE5);
+        reg0.refined.TUNE_INT_MODE= 1;
+        setRegister(REG_SOFTMUTE5,reg0.raw);
+
+        reg1.raw = getCachedRegister(REG_SOFTMUTE2);
+        reg1.refined.TUNE_INT_PL= 0;
+        setRegister(REG_SOFTMUTE2,reg1.raw);
+    }
+
+     //set INT Mode TUNE_INT_EN  0x22<7>  to 1
+     reg0.raw = getCachedRegister(REG_SOFTMUTE5);
+     reg0.refined.TUNE_INT_EN= 1;
+     setRegister(REG_SOFTMUTE5,reg0.raw);
+
+    //set INT_PIN to b(00) as auto cleard interrupt signal.
+    kt09xx_anacfg_1 reg2;
+    reg2.raw = getCachedRegister(REG_ANACFG1);
+    reg2.refined.INT_PIN= 0;
+    setRegister(REG_ANACFG1,reg2.raw);
+
+}
+
+void KT0937::enableINT()
+{
+    KT0937LockGuard transaction(&this->configLock);
+
+    kt09xx_softmute_5 reg;
+    //set INT Mode TUNE_INT_EN  0x22<7>  to 1
+    reg.raw = getCachedRegister(REG_SOFTMUTE5);
+    reg.refined.TUNE_INT_EN= 1;
+    setRegister(REG_SOFTMUTE5,reg.raw);
+
+    //set INT_PIN to b(00) as auto cleard interrupt signal.
+    kt09xx_anacfg_1 reg2;
+    reg2.raw = getCachedRegister(REG_ANACFG1);
+    reg2.refined.INT_PIN= 0;
+    setRegister(REG_ANACFG1,reg2.raw);
+}
+
+void KT0937::setSWOnPin(int sw_on_pin_temp)
+{
+    KT0937LockGuard transaction(&this->configLock);
+
+    this->swOnPin = sw_on_pin_temp;
+}
+
+#if KT0937_TRACE
+/**
+ * @ingroup GA03
+ * @brief Records a register access in the I2C tracer. See KT0937_TRACE
+ * 
+ * @param reg        register number
+ * @param value      register content read or written
+ * @param direction  TRACE_READ or TRACE_WRITE
+ */
+void KT0937::traceAccess(int reg, uint8_t value, uint8_t direction)
+{
+    kt09xx_trace_entry *entry = &this->traceBuffer[this->traceHead];
+    entry->timestamp = micros();
+    entry->reg = reg;
+    entry->value = value;
+    entry->direction = direction;
+
+    this->traceHead = (this->traceHead + 1) % KT0937_TRACE_SIZE;
+    if (this->traceCount < KT0937_TRACE_SIZE)
+        this->traceCount++;
+
+    if (reg < 0 || reg >= KT0937_REG_COUNT)
+        return;
+    uint16_t *counter = (direction == TRACE_WRITE) ? &this->traceWrites[reg] : &this->traceReads[reg];
+    if (*counter != 0xFFFF)
+        (*counter)++;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Clears the I2C tracer ring buffer and the per-register counters
+ */
+void KT0937::clearTrace()
+{
+    KT0937LockGuard bus(&this->busLock);
+
+    this->traceHead = 0;
+    this->traceCount = 0;
+    memset(this->traceReads, 0, sizeof(this->traceReads));
+    memset(this->traceWrites, 0, sizeof(this->traceWrites));
+}
+
+/**
+ * @ingroup GA03
+ * @brief Gets the number of entries in the I2C tracer ring buffer (up to KT0937_TRACE_SIZE)
+ */
+uint8_t KT0937::getTraceCount()
+{
+    return this->traceCount;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Gets an entry of the I2C tracer ring buffer
+ * @param i  0 = oldest entry; getTraceCount() - 1 = newest entry
+ */
+kt09xx_trace_entry KT0937::getTraceEntry(uint8_t i)
+{
+    uint8_t oldest = (this->traceHead + KT0937_TRACE_SIZE - this->traceCount) % KT0937_TRACE_SIZE;
+    return this->traceBuffer[(oldest + i) % KT0937_TRACE_SIZE];
+}
+
+/**
+ * @ingroup GA03
+ * @brief Gets the number of reads of a given register since the last clearTrace()
+ */
+uint16_t KT0937::getRegisterReads(int reg)
+{
+    return (reg >= 0 && reg < KT0937_REG_COUNT) ? this->traceReads[reg] : 0;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Gets the number of writes of a given register since the last clearTrace()
+ */
+uint16_t KT0937::getRegisterWrites(int reg)
+{
+    return (reg >= 0 && reg < KT0937_REG_COUNT) ? this->traceWrites[reg] : 0;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Prints the I2C tracer ring buffer, oldest entry first
+ * @details One line per access: "<micros> R|W 0x<register> 0x<value>". E.g. dumpTrace(Serial).
+ * 
+ * @param out  where to print (Serial, a display...)
+ */
+void KT0937::dumpTrace(Print &out)
+{
+    KT0937LockGuard bus(&this->busLock);
+
+    for (uint8_t i = 0; i < this->traceCount; i++)
+    {
+        kt09xx_trace_entry entry = getTraceEntry(i);
+        out.print(entry.timestamp);
+        out.print(entry.direction == TRACE_WRITE ? " W 0x" : " R 0x");
+        out.print(entry.reg, HEX);
+        out.print(" 0x");
+        out.println(entry.value, HEX);
+    }
+}
+
+/**
+ * @ingroup GA03
+ * @brief Prints the most accessed registers, most accessed first
+ * @details One line per register: "0x<register> R <reads> W <writes> ####" (one # per 1/32 of the hottest 
+ * @details register accesses). E.g. dumpRegisterHistogram(Serial, 10).
+ * 
+ * @param out  where to print (Serial, a display...)
+ * @param top  number of registers to print
+ */
+void KT0937::dumpRegisterHistogram(Print &out, uint8_t top)
+{
+    KT0937LockGuard bus(&this->busLock);
+
+    uint32_t limit = 0xFFFFFFFF;    // accesses of the last register printed
+    int limitReg = -1;
+    uint32_t hottest = 0;
+
+    while (top--)
+    {
+        //next register by decreasing number of accesses (ties by increasing register number)
+        int reg = -1;
+        uint32_t accesses = 0;
+        for (int r = 0; r < KT0937_REG_COUNT; r++)
+        {
+            uint32_t n = (uint32_t) this->traceReads[r] + this->traceWrites[r];
+            if (n == 0 || n > limit || (n == limit && r <= limitReg))
+                continue;
+            if (n > accesses)
+            {
+                reg = r;
+                accesses = n;
+            }
+        }
+        if (reg < 0)
+            return;
+
+        if (hottest == 0)
+            hottest = accesses;
+        limit = accesses;
+        limitReg = reg;
+
+        out.print("0x");
+        out.print(reg, HEX);
+        out.print(" R ");
+        out.print(this->traceReads[reg]);
+        out.print(" W ");
+        out.print(this->traceWrites[reg]);
+        out.print(" ");
+        for (uint32_t bar = (accesses * 32 + hottest - 1) / hottest; bar; bar--)
+            out.print("#");
+        out.println();
+    }
+}
+#endif
+
+/**
+ * @ingroup GA03
+ * @brief Adds an entry to the command queue
+ * @return false if the queue is full
+ */
+bool KT0937::pushCommand(uint8_t type, uint8_t reg, uint8_t value, uint8_t mask, kt09xx_command_callback callback)
+{
+    if (this->queueCount >= KT0937_QUEUE_SIZE)
+        return false;
+
+    kt09xx_command *c = &this->commandQueue[this->queueHead];
+    c->type = type;
+    c->reg = reg;
+    c->value = value;
+    c->mask = mask;
+    c->callback = callback;
+
+    this->queueHead = (this->queueHead + 1) % KT0937_QUEUE_SIZE;
+    this->queueCount++;
+    return true;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Gets the number of free entries of the command queue
+ */
+uint8_t KT0937::getQueueFree()
+{
+    KT0937LockGuard transaction(&this->configLock);
+
+    return KT0937_QUEUE_SIZE - this->queueCount;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Queues a register write. It is run by poll()
+ * @details Only the bits set in mask are written; the others keep the register content when the write runs. 
+ * @details Synchronous calls (setVolume, setBand...) do not go through the queue: do not mix them with queued 
+ * @details writes of the same registers.
+ * 
+ * @param reg    register number
+ * @param value  register content
+ * @param mask   bits of value to be written
+ * @return false if the queue is full (nothing queued)
+ */
+bool KT0937::queueRegister(int reg, uint8_t value, uint8_t mask)
+{
+    KT0937LockGuard transaction(&this->configLock);
+
+    return pushCommand(COMMAND_WRITE, reg, value, mask, NULL);
+}
+
+/**
+ * @ingroup GA03
+ * @brief Queues a completion callback. poll() calls it once every command queued before it has landed.
+ * 
+ * @param callback  function called as callback(tag, getErrorCode())
+ * @param tag       value passed to the callback
+ * @return false if the queue is full (nothing queued)
+ */
+bool KT0937::queueCallback(kt09xx_command_callback callback, uint8_t tag)
+{
+    KT0937LockGuard transaction(&this->configLock);
+
+    return pushCommand(COMMAND_CALLBACK, tag, 0, 0, callback);
+}
+
+/**
+ * @ingroup GA03
+ * @brief Queues a volume change. Asynchronous version of setVolume
+ * 
+ * @param volume    0 ~ 31
+ * @param callback  optional completion callback. See queueCallback
+ * @param tag       value passed to the callback
+ * @return false if the queue is full (nothing queued)
+ */
+bool KT0937::queueVolume(int8_t volume, kt09xx_command_callback callback, uint8_t tag)
+{
+    KT0937LockGuard transaction(&this->configLock);
+
+    if (getQueueFree() < (callback ? 2 : 1))
+        return false;
+
+    if (volume > 31)
+        volume = 31;
+    else if (volume < 0)
+        volume = 0;
+    this->currentVolume = volume;
+
+    kt09xx_rxcfg_1 value, mask;
+    value.raw = mask.raw = 0;
+    value.refined.VOLUME = this->muted ? 0 : volume;
+    mask.refined.VOLUME = 31;
+    queueRegister(REG_RXCFG1, value.raw, mask.raw);
+    if (callback)
+        queueCallback(callback, tag);
+    return true;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Queues a band switch. Asynchronous version of setBand(const kt09xx_band_image &)
+ * @details Same steps as setBand: shut down the ADC of CH pin, band registers, CHANGE_BAND, turn on the ADC 
+ * @details of CH pin. poll() waits for the device to clear CHANGE_BAND without blocking. Registers already 
+ * @details holding their value are not written. currentMode and the seek / scan range keep describing the 
+ * @details old band until the device has switched (see loadBandState).
+ * 
+ * @param image     band register image. See getBandImage
+ * @param callback  optional completion callback, called once the device has switched band. See queueCallback
+ * @param tag       value passed to the callback (e.g. the band number)
+ * @return false if the queue is full (nothing queued)
+ */
+bool KT0937::queueBand(const kt09xx_band_image &image, kt09xx_command_callback callback, uint8_t tag)
+{
+    KT0937LockGuard transaction(&this->configLock);
+
+    if (getQueueFree() < BAND_REG_COUNT + 3 + (this->rssiBiasEnabled ? 1 : 0) + (callback ? 1 : 0))
+        return false;
+
+    kt09xx_bandcfg_0 bandcfg0;
+    kt09xx_fm_chan_0 fmchan0, fmchan0Mask;
+    bandcfg0.raw = image.reg[0];
+    fmchan0.raw = image.reg[5];
+    const uint8_t *mask = (fmchan0.refined.AM_FM == MODE_FM) ? fmBandMask : (bandcfg0.refined.SW_EN ? swBandMask : mwBandMask);
+
+    //shut down ADCCH
+    kt09xx_adc_0 adc0, adc0Mask;
+    adc0.raw = adc0Mask.raw = 0;
+    adc0.refined.CH_ADC_DIS = 1;
+    adc0Mask.refined.CH_ADC_DIS = 1;
+    queueRegister(REG_ADC0, adc0.raw, adc0Mask.raw);
+
+    //band registers, FMCHAN0 last with CHANGE_BAND=1
+    for (uint8_t i = 0; i < BAND_REG_COUNT; i++)
+        if (i != 5)
+            queueRegister(bandRegisters[i], image.reg[i], mask[i]);
+    if (this->rssiBiasEnabled)
+    {
+        uint8_t calibrationBand = getImageCalibrationBand(image.reg);
+        queueRegister((calibrationBand == CALIBRATION_FM) ? REG_DSPCFG6 : REG_AMDSP1, 
+                      (uint8_t) this->rssiBias[calibrationBand] & RSSI_BIAS_MASK, RSSI_BIAS_MASK);
+    }
+    fmchan0Mask.raw = mask[5];
+    fmchan0.refined.CHANGE_BAND = 1;
+    fmchan0Mask.refined.CHANGE_BAND = 1;
+    queueRegister(REG_FMCHAN0, fmchan0.raw, fmchan0Mask.raw);
+
+    //currentMode and seek / scan range of the new band, once the device has switched
+    pushCommand(COMMAND_BAND_STATE, 0, 0, 0, NULL);
+
+    //turn on ADCCH
+    adc0.refined.CH_ADC_DIS = 0;
+    adc0.refined.CH_ADC_START = 1;
+    adc0Mask.refined.CH_ADC_START = 1;
+    queueRegister(REG_ADC0, adc0.raw, adc0Mask.raw);
+
+    if (callback)
+        queueCallback(callback, tag);
+    return true;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Checks whether the last write run by poll() has settled
+ * @details Never waits: the settling time is compared with micros() and the readiness flag is read once.
+ * @return true if the next command can run
+ */
+bool KT0937::pollTimingPolicy()
+{
+    if (!this->queueWaiting)
+        return true;
+
+    uint32_t elapsedUs = micros() - this->queueWaitStart;
+    if (elapsedUs < this->queueSettleUs)
+        return false;
+
+    const kt09xx_timing_policy *p = this->queueFlagPolicy;
+    if (p && (getRegister(p->flagReg) & p->flagMask) != p->flagState)
+    {
+        if (elapsedUs < (uint32_t) p->timeoutMs * 1000)
+            return false;
+        this->errorCode = p->errorCode;
+    }
+
+    this->queueWaiting = false;
+    return true;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Runs the command queue. Call it from loop() as often as possible.
+ * @details Never blocks: it runs the queued commands until one of them has to wait for the device (settling 
+ * @details time or readiness flag of the timing policy table) and returns. Consecutive register writes are 
+ * @details sent in one burst; registers already holding their value are skipped.
+ * 
+ * @return true if the queue is empty and the last write has settled
+ */
+bool KT0937::poll()
+{
+    KT0937LockGuard transaction(&this->configLock);
+
+    while (pollTimingPolicy() && this->queueCount)
+    {
+        kt09xx_command *c = &this->commandQueue[this->queueTail];
+
+        if (c->type == COMMAND_CALLBACK)
+        {
+            kt09xx_command_callback callback = c->callback;
+            uint8_t tag = c->reg;
+            this->queueTail = (this->queueTail + 1) % KT0937_QUEUE_SIZE;
+            this->queueCount--;
+            callback(tag, this->errorCode);
+            continue;
+        }
+
+        if (c->type == COMMAND_BAND_STATE)
+        {
+            this->queueTail = (this->queueTail + 1) % KT0937_QUEUE_SIZE;
+            this->queueCount--;
+            loadBandState();
+            continue;
+        }
+
+        //run of writes to consecutive registers
+        uint8_t buf[KT0937_BURST_MAX];
+        uint8_t n = 0;
+        uint8_t start = c->reg;
+        while (n < this->queueCount && n < KT0937_BURST_MAX)
+        {
+            kt09xx_command *w = &this->commandQueue[(this->queueTail + n) % KT0937_QUEUE_SIZE];
+            if (w->type != COMMAND_WRITE || w->reg != (uint8_t) (start + n))
+                break;
+            buf[n] = (getCachedRegister(w->reg) & ~w->mask) | (w->value & w->mask);
+            n++;
+        }
+        this->queueTail = (this->queueTail + n) % KT0937_QUEUE_SIZE;
+        this->queueCount -= n;
+
+        //skip the registers already holding their value (trigger bits are always written)
+        uint8_t first = 0, last = n;
+        while (first < last && isShadowEqual(start + first, buf[first]) && !(buf[first] & getTriggerMask(start + first)))
+            first++;
+        while (last > first && isShadowEqual(start + last - 1, buf[last - 1]) && !(buf[last - 1] & getTriggerMask(start + last - 1)))
+            last--;
+        if (first == last)
+            continue;
+
+        this->queueSettleUs = 0;
+        this->queueFlagPolicy = NULL;
+        this->deferTimingPolicy = true;
+        writeRegisters(start + first, &buf[first], last - first);
+        this->deferTimingPolicy = false;
+
+        if (this->queueSettleUs || this->queueFlagPolicy)
+        {
+            this->queueWaiting = true;
+            this->queueWaitStart = micros();
+        }
+    }
+
+    return !this->queueCount && !this->queueWaiting;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Sets the function called by serviceTuneEvents() when the channel has changed
+ * @details The tuning interrupt must be enabled (setIntMode, enableINT) and the INT pin ISR must call 
+ * @details onTuneInterrupt(). E.g. 
+ * @details     void IRAM_ATTR tuneISR() { radio.onTuneInterrupt(); } 
+ * @details     attachInterrupt(digitalPinToInterrupt(PIN_KT_INT), tuneISR, FALLING); 
+ * @details     radio.onChannelChanged(showChannel); 
+ * @details and loop() calls radio.serviceTuneEvents().
+ * 
+ * @param callback  function called as callback(frequency kHz, rssi, snr). NULL = none
+ */
+void KT0937::onChannelChanged(kt09xx_channel_callback callback)
+{
+    this->channelChangedCallback = callback;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Records a tuning interrupt. Call it from the INT pin ISR.
+ * @details Only stores micros() in a single producer / single consumer ring buffer: no I2C, no lock. 
+ * @details When the ring buffer is full the interrupt is counted in getTuneEventOverflow() and dropped 
+ * @details (the pending events already make serviceTuneEvents() read the channel).
+ */
+void KT0937_ISR_ATTR KT0937::onTuneInterrupt()
+{
+    uint8_t head = this->tuneEventHead;
+    uint8_t next = (head + 1) & (KT0937_EVENT_SIZE - 1);
+
+    if (next == this->tuneEventTail)
+    {
+        //free running counter: serviceTuneEvents only takes a snapshot, so no count is lost. Saturates at 255
+        if ((uint8_t) (this->tuneEventOverflow - this->tuneEventOverflowSeen) != 0xFF)
+            this->tuneEventOverflow++;
+        return;
+    }
+
+    this->tuneEventTime[head] = micros();
+    this->tuneEventHead = next;     // publish the entry once it is written
+    this->telemetryKick = true;
+    this->signalHistoryStale = true;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Services the tuning interrupts recorded by onTuneInterrupt(). Call it from loop().
+ * @details A burst of dial interrupts is coalesced: nothing is done until the dial has been quiet for 
+ * @details KT0937_EVENT_QUIET_US, then all pending events are consumed with one status block read (readStatus: 
+ * @details STATUS6/7 channel, RSSI and SNR in one burst) and the onChannelChanged callback is called if the 
+ * @details channel is not the one delivered last time.
+ * 
+ * @return true if the channel has changed
+ */
+bool KT0937::serviceTuneEvents()
+{
+    uint8_t head = this->tuneEventHead;
+    if (head == this->tuneEventTail)
+        return false;
+
+    uint32_t last = this->tuneEventTime[(head - 1) & (KT0937_EVENT_SIZE - 1)];
+    if ((micros() - last) < KT0937_EVENT_QUIET_US)
+        return false;
+
+    this->tuneEventTail = head;
+    this->tuneEventOverflowSeen = this->tuneEventOverflow;
+
+    kt09xx_signal_status status;
+    readStatus(status);
+    if (status.channel == this->lastEventChannel)
+        return false;
+    this->lastEventChannel = status.channel;
+
+    if (this->channelChangedCallback)
+    {
+        uint32_t frequency = (this->currentMode == MODE_FM) ? (uint32_t) status.channel * FM_CHANNEL_KHZ : (uint32_t) status.channel * AM_CHANNEL_KHZ;
+        this->channelChangedCallback(frequency, this->currentRSSI, this->currentSNR);
+    }
+    return true;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Gets the number of tuning interrupts dropped because the ring buffer was full (since the last service)
+ */
+uint8_t KT0937::getTuneEventOverflow()
+{
+    return (uint8_t) (this->tuneEventOverflow - this->tuneEventOverflowSeen);
+}
+
+/**
+ * @ingroup GA03
+ * @brief Sets the function called by pollTelemetry when a metric has changed. NULL = telemetry off
+ * 
+ * @param callback  called as callback(status, changed). changed: TELEMETRY_CHANNEL, TELEMETRY_RSSI, 
+ *                  TELEMETRY_SNR, TELEMETRY_STEREO, TELEMETRY_VALID. The first call has every bit set.
+ */
+void KT0937::onTelemetry(kt09xx_telemetry_callback callback)
+{
+    this->telemetryCallback = callback;
+    this->telemetryReportedMode = 0xFF;
+    this->telemetryKick = true;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Sets the telemetry sampling intervals
+ * @details The status block is sampled every fastMs after a tune or a change, then the interval doubles after 
+ * @details each sample without change, up to slowMs.
+ * 
+ * @param fastMs  shortest interval (default TELEMETRY_FAST_MS)
+ * @param slowMs  longest interval, while the signal is stable (default TELEMETRY_SLOW_MS)
+ */
+void KT0937::setTelemetryRate(uint16_t fastMs, uint16_t slowMs)
+{
+    this->telemetryFastMs = fastMs;
+    this->telemetrySlowMs = (slowMs < fastMs) ? fastMs : slowMs;
+    this->telemetryKick = true;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Sets how far RSSI and SNR have to move from the value reported last to be reported again
+ * 
+ * @param rssi  dB (default TELEMETRY_RSSI_HYSTERESIS)
+ * @param snr   SNR units (default TELEMETRY_SNR_HYSTERESIS)
+ */
+void KT0937::setTelemetryHysteresis(uint8_t rssi, uint8_t snr)
+{
+    this->telemetryRSSIHysteresis = rssi;
+    this->telemetrySNRHysteresis = snr;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Gets the current telemetry sampling interval
+ * @return milliseconds; 0 if there is no telemetry callback
+ */
+uint16_t KT0937::getTelemetryInterval()
+{
+    if (this->telemetryCallback == NULL)
+        return 0;
+    return this->telemetryKick ? this->telemetryFastMs : this->telemetryIntervalMs;
+}
+
+static bool isOutsideHysteresis(uint8_t value, uint8_t reported, uint8_t hysteresis)
+{
+    return (value > reported) ? (value - reported) >= hysteresis : (reported - value) >= hysteresis;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Compares a status snapshot with the one reported last
+ * @return changed metrics (TELEMETRY_*). Every bit if nothing was reported in the current mode yet
+ */
+uint8_t KT0937::getTelemetryChanges(const kt09xx_signal_status &status)
+{
+    if (this->telemetryReportedMode != this->currentMode)
+        return TELEMETRY_CHANNEL | TELEMETRY_RSSI | TELEMETRY_SNR | TELEMETRY_STEREO | TELEMETRY_VALID;
+
+    const kt09xx_signal_status *last = &this->telemetryReported;
+    bool fm = (this->currentMode == MODE_FM);
+    uint8_t changed = 0;
+
+    if (status.channel != last->channel)
+        changed |= TELEMETRY_CHANNEL;
+    if (isOutsideHysteresis(fm ? status.fmRSSI : status.amRSSI, fm ? last->fmRSSI : last->amRSSI, this->telemetryRSSIHysteresis))
+        changed |= TELEMETRY_RSSI;
+    if (isOutsideHysteresis(fm ? status.fmSNR : status.amSNR, fm ? last->fmSNR : last->amSNR, this->telemetrySNRHysteresis))
+        changed |= TELEMETRY_SNR;
+    if (status.stereo != last->stereo)
+        changed |= TELEMETRY_STEREO;
+    if (status.valid != last->valid)
+        changed |= TELEMETRY_VALID;
+    return changed;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Samples the status block when it is due and calls the telemetry callback if a metric has changed
+ * @details Call it from loop() (or let KT0937Service run it). Never waits: between two samples it returns at 
+ * @details once, without bus traffic. A sample is one readStatus burst, which takes the bus lock only. 
+ * @details A tune (CHANGE_BAND written by setBand, setChannel, seek, poll...) or a tuning interrupt brings the 
+ * @details interval back to the fast rate, so the new channel is reported quickly; a stable signal is sampled 
+ * @details at the slow rate only.
+ * 
+ * @return true if the callback has been called
+ */
+bool KT0937::pollTelemetry()
+{
+    if (this->telemetryCallback == NULL)
+        return false;
+
+    uint32_t now = millis();
+    if (this->telemetryKick)
+    {
+        //let the new channel settle for one fast interval
+        this->telemetryKick = false;
+        this->telemetryIntervalMs = this->telemetryFastMs;
+        this->telemetryTime = now;
+        return false;
+    }
+    if ((now - this->telemetryTime) < this->telemetryIntervalMs)
+        return false;
+    this->telemetryTime = now;
+
+    kt09xx_signal_status status;
+    readStatus(status);
+    uint8_t changed = getTelemetryChanges(status);
+    if (!changed)
+    {
+        uint32_t interval = (uint32_t) this->telemetryIntervalMs * 2;
+        this->telemetryIntervalMs = (interval > this->telemetrySlowMs) ? this->telemetrySlowMs : interval;
+        return false;
+    }
+
+    this->telemetryIntervalMs = this->telemetryFastMs;
+    this->telemetryReported = status;
+    this->telemetryReportedMode = this->currentMode;
+    this->telemetryCallback(status, changed);
+    return true;
+}
+
+/*
+* ring buffer lock of KT0937Service: posts come from tasks on both cores and from ISRs
+*/
+#if KT0937_LOCK == KT0937_LOCK_FREERTOS && defined(ESP32)
+#define SERVICE_RING_LOCK()         portENTER_CRITICAL(&this->ringMux)
+#define SERVICE_RING_UNLOCK()       portEXIT_CRITICAL(&this->ringMux)
+#define SERVICE_RING_LOCK_ISR()     portENTER_CRITICAL_ISR(&this->ringMux)
+#define SERVICE_RING_UNLOCK_ISR()   portEXIT_CRITICAL_ISR(&this->ringMux)
+#elif KT0937_LOCK == KT0937_LOCK_FREERTOS
+#define SERVICE_RING_LOCK()         taskENTER_CRITICAL()
+#define SERVICE_RING_UNLOCK()       taskEXIT_CRITICAL()
+#define SERVICE_RING_LOCK_ISR()     UBaseType_t ringMask = taskENTER_CRITICAL_FROM_ISR()
+#define SERVICE_RING_UNLOCK_ISR()   taskEXIT_CRITICAL_FROM_ISR(ringMask)
+#elif KT0937_LOCK == KT0937_LOCK_STD
+#define SERVICE_RING_LOCK()         this->ringMutex.lock()
+#define SERVICE_RING_UNLOCK()       this->ringMutex.unlock()
+#define SERVICE_RING_LOCK_ISR()     this->ringMutex.lock()
+#define SERVICE_RING_UNLOCK_ISR()   this->ringMutex.unlock()
+#else
+#define SERVICE_RING_LOCK()         noInterrupts()
+#define SERVICE_RING_UNLOCK()       interrupts()
+#define SERVICE_RING_LOCK_ISR()     ((void) 0)      // interrupts are already disabled
+#define SERVICE_RING_UNLOCK_ISR()   ((void) 0)
+#endif
+
+/**
+ * @ingroup GA03
+ * @brief Radio service in front of a KT0937
+ * 
+ * @param radio  KT0937 driven by the service
+ */
+KT0937Service::KT0937Service(KT0937 &radio)
+{
+    this->radio = &radio;
+}
+
+#if KT0937_LOCK == KT0937_LOCK_FREERTOS
+/**
+ * @ingroup GA03
+ * @brief Starts the service task. From then on the task runs the posted commands: do not call poll()
+ * @details The task sleeps until a command is posted, so it costs no CPU time while the radio is left alone.
+ * 
+ * @param priority   FreeRTOS task priority
+ * @param core       ESP32: core the task is pinned to (0 or 1); -1 = no affinity. Ignored elsewhere
+ * @param stackSize  task stack size (FreeRTOS stack units)
+ * @return false if the task could not be created
+ */
+bool KT0937Service::begin(UBaseType_t priority, int8_t core, uint32_t stackSize)
+{
+    if (this->task)
+        return true;
+
+#if defined(ESP32)
+    BaseType_t created = xTaskCreatePinnedToCore(taskMain, "kt0937", stackSize, this, priority, &this->task, 
+                                                 (core < 0) ? tskNO_AFFINITY : core);
+#else
+    (void) core;
+    BaseType_t created = xTaskCreate(taskMain, "kt0937", stackSize, this, priority, &this->task);
+#endif
+    return created == pdPASS;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Service task: runs everything pending, then sleeps until a command is posted or telemetry is due
+ */
+void KT0937Service::taskMain(void *arg)
+{
+    KT0937Service *service = (KT0937Service *) arg;
+
+    for (;;)
+    {
+        service->poll();    // first pass: commands posted before begin()
+        uint16_t telemetryMs = service->radio->getTelemetryInterval();
+        ulTaskNotifyTake(pdTRUE, telemetryMs ? pdMS_TO_TICKS(telemetryMs) : portMAX_DELAY);
+    }
+}
+#endif
+
+/**
+ * @ingroup GA03
+ * @brief Adds a command to the ring buffer. The caller holds the ring buffer lock
+ * @details A command replaces a waiting command of the same type, so a burst of volume changes takes one 
+ * @details entry. Tunes and band switches keep their order: one never replaces another across the other type.
+ * @return false if the ring buffer is full
+ */
+bool KT0937Service::pushRing(const kt09xx_service_command &command)
+{
+    bool ordered = (command.type == SERVICE_TUNE || command.type == SERVICE_BAND);
+
+    for (uint8_t n = this->ringCount; n > 0; n--)
+    {
+        kt09xx_service_command *waiting = &this->ring[(this->ringTail + n - 1) % KT0937_SERVICE_QUEUE_SIZE];
+        if (waiting->type == command.type)
+        {
+            *waiting = command;
+            this->ringCoalescedCount++;
+            return true;
+        }
+        if (ordered && (waiting->type == SERVICE_TUNE || waiting->type == SERVICE_BAND))
+            break;
+    }
+
+    if (this->ringCount >= KT0937_SERVICE_QUEUE_SIZE)
+    {
+        this->overflowCount++;
+        return false;
+    }
+
+    this->ring[this->ringHead] = command;
+    this->ringHead = (this->ringHead + 1) % KT0937_SERVICE_QUEUE_SIZE;
+    this->ringCount++;
+    return true;
 }
 
-uint8_t KT0937::getFMSNR()
-{   
-    kt09xx_status_4 reg;
-    reg.raw = getRegister(REG_STATUS4);
-    this->currentFMSNR = reg.refined.FM_SNR;  // 0 minimum , 63 maximum
-    return this->currentFMSNR;
+/**
+ * @ingroup GA03
+ * @brief Posts a command from a task (or from loop). Never waits for the bus
+ * @return false if the queue is full (see getOverflowCount)
+ */
+bool KT0937Service::post(const kt09xx_service_command &command)
+{
+    SERVICE_RING_LOCK();
+    bool queued = pushRing(command);
+    SERVICE_RING_UNLOCK();
+
+#if KT0937_LOCK == KT0937_LOCK_FREERTOS
+    if (queued && this->task)
+        xTaskNotifyGive(this->task);
+#endif
+    return queued;
 }
 
-uint8_t KT0937::getRSSI()
+/**
+ * @ingroup GA03
+ * @brief Posts a command from an interrupt service routine
+ * @return false if the queue is full (see getOverflowCount)
+ */
+bool KT0937Service::postFromISR(const kt09xx_service_command &command)
 {
-    if(this->currentMode == MODE_AM)
+    SERVICE_RING_LOCK_ISR();
+    bool queued = pushRing(command);
+    SERVICE_RING_UNLOCK_ISR();
+
+#if KT0937_LOCK == KT0937_LOCK_FREERTOS
+    if (queued && this->task)
     {
-        this->currentRSSI = this->getAMRSSI();
-    }else if( this->currentMode == MODE_FM)
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(this->task, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+#endif
+    return queued;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Takes the oldest posted command off the ring buffer
+ * @return false if nothing was posted
+ */
+bool KT0937Service::receive(kt09xx_service_command &command)
+{
+    SERVICE_RING_LOCK();
+    bool received = (this->ringCount != 0);
+    if (received)
     {
-        this->currentRSSI = this->getFMRSSI();
+        command = this->ring[this->ringTail];
+        this->ringTail = (this->ringTail + 1) % KT0937_SERVICE_QUEUE_SIZE;
+        this->ringCount--;
     }
-    return(this->currentRSSI);
+    SERVICE_RING_UNLOCK();
+    return received;
 }
 
-uint8_t KT0937::getSNR()
+/**
+ * @ingroup GA03
+ * @brief Moves a posted command into the pending slot of its type
+ * @details The newest command of a type replaces the pending one. A band switch also replaces the pending 
+ * @details tune: the band registers set the channel anyway.
+ */
+void KT0937Service::coalesce(const kt09xx_service_command &command)
 {
-    if(this->currentMode == MODE_AM)
+    if (command.type >= SERVICE_COMMAND_COUNT)
+        return;
+
+    if (command.type == SERVICE_BAND && (this->pendingMask & (1 << SERVICE_TUNE)))
     {
-        this->currentSNR = this->getAMSNR();
-    }else if( this->currentMode == MODE_FM)
+        this->pendingMask &= ~(1 << SERVICE_TUNE);
+        this->coalescedCount++;
+    }
+    if (this->pendingMask & (1 << command.type))
+        this->coalescedCount++;
+
+    this->pending[command.type] = command;
+    this->pendingMask |= (1 << command.type);
+}
+
+/**
+ * @ingroup GA03
+ * @brief Picks up the posted commands and runs the pending command of highest priority
+ * @details A pending tune is always newer than a pending band switch (see coalesce), so it waits for it.
+ * @return false if nothing was pending
+ */
+bool KT0937Service::runNext()
+{
+    kt09xx_service_command command;
+    while (receive(command))
+        coalesce(command);
+
+    if (!this->pendingMask)
+        return false;
+
+    uint8_t type = 0;
+    while (!(this->pendingMask & (1 << type)))
+        type++;
+    if (type == SERVICE_TUNE && (this->pendingMask & (1 << SERVICE_BAND)))
+        type = SERVICE_BAND;
+
+    this->pendingMask &= ~(1 << type);
+    run(this->pending[type]);
+    return true;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Runs one command on the radio, then calls the onCompleted callback
+ */
+void KT0937Service::run(const kt09xx_service_command &command)
+{
+    switch (command.type)
     {
-        this->currentSNR = this->getFMSNR();
+    case SERVICE_MUTE:
+        this->radio->setMute(command.value);
+        break;
+    case SERVICE_VOLUME:
+        this->radio->setVolume(command.value);
+        break;
+    case SERVICE_TUNE:
+        this->radio->setChannel(command.channel);
+        break;
+    case SERVICE_BAND:
+        this->radio->setBand(command.image);
+        break;
+    case SERVICE_STATUS:
+        kt09xx_signal_status status;
+        this->radio->readStatus(status);
+        if (this->statusCallback)
+            this->statusCallback(status);
+        break;
     }
-    return(this->currentSNR);
 
+    if (this->completedCallback)
+        this->completedCallback(command.type, this->radio->getErrorCode());
 }
 
 /**
  * @ingroup GA03
- * @brief 
- *    Register TUNE_INT_EN is used to enable the interrupt. When TUNE_INT_EN=1, the change of CH pin 
- *voltage will lead to the interrupt signal of INT pin. When TUNE_INT_EN=0, whether CH pin voltage 
- *changes or not, the INT pin will not output the interrupt signal. 
- *
- *   Register TUNE_INT_MODE is used to select the mode of interrupt. When TUNE_INT_MODE=1, 
- *KT0937 will output the pulse interrupt signal. When TUNE_INT_MODE=0, KT0937 will output the level 
- *interrupt signal.
- *  Register TUNE_INT_PL is used to set the polarity of the interrupt signal while tuning. When 
- *TUNE_INT_PL=0, the output of interrupt is low level or negative pulse signal. When TUNE_INT_PL=1, 
- *the output of interrupt is high level or positive pulse signal.
- *   There is no need to clear the interrupt in MCU when it shows the pulse signal, KT0937 can do it 
- *automatically. But if there is a low level signal showed, just set INT_PIN<1:0> in 2b’01 to clear the 
- *interrupt output. And as the case of high level signal, INT_PIN<1:0> should be set in 2b’10 to clear the 
- *interrupt output.
- * 
- * @see enable INT mode
- * 
- * @param 
+ * @brief Posts a mute or unmute. See KT0937::setMute
+ * @return false if the queue is full
+ */
+bool KT0937Service::setMute(bool mute)
+{
+    kt09xx_service_command command;
+    command.type = SERVICE_MUTE;
+    command.value = mute;
+    return post(command);
+}
+
+/**
+ * @ingroup GA03
+ * @brief Posts a volume change. See KT0937::setVolume
+ * @param volume  0 ~ 31
+ * @return false if the queue is full
+ */
+bool KT0937Service::setVolume(int8_t volume)
+{
+    kt09xx_service_command command;
+    command.type = SERVICE_VOLUME;
+    command.value = (volume > 31) ? 31 : ((volume < 0) ? 0 : volume);
+    return post(command);
+}
+
+/**
+ * @ingroup GA03
+ * @brief Posts a channel change. See KT0937::setChannel
+ * @return false if the queue is full
+ */
+bool KT0937Service::setChannel(uint16_t channel)
+{
+    kt09xx_service_command command;
+    command.type = SERVICE_TUNE;
+    command.channel = channel;
+    return post(command);
+}
+
+/**
+ * @ingroup GA03
+ * @brief Posts a band switch. The image is copied. See KT0937::setBand
+ * @return false if the queue is full
+ */
+bool KT0937Service::setBand(const kt09xx_band_image &image)
+{
+    kt09xx_service_command command;
+    command.type = SERVICE_BAND;
+    command.image = image;
+    return post(command);
+}
+
+/**
+ * @ingroup GA03
+ * @brief Posts a status read. The snapshot is delivered to the onStatus callback
+ * @return false if the queue is full
+ */
+bool KT0937Service::requestStatus()
+{
+    kt09xx_service_command command;
+    command.type = SERVICE_STATUS;
+    return post(command);
+}
+
+/**
+ * @ingroup GA03
+ * @brief Sets the function called with each status snapshot (SERVICE_STATUS). Called in the service context
+ */
+void KT0937Service::onStatus(kt09xx_status_callback callback)
+{
+    this->statusCallback = callback;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Sets the function called after each command has run, as callback(type, errorCode)
+ * @details Called in the service context. Commands replaced by a newer one (see coalesce) never run.
+ */
+void KT0937Service::onCompleted(kt09xx_command_callback callback)
+{
+    this->completedCallback = callback;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Runs every pending command, by priority, then the telemetry poller (see KT0937::pollTelemetry)
+ * @details Call it from loop() when there is no service task.
+ * @return true if at least one command has run
+ */
+bool KT0937Service::poll()
+{
+    bool ran = false;
+    while (runNext())
+        ran = true;
+    this->radio->pollTelemetry();
+    return ran;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Gets the number of commands replaced by a newer one before they ran
+ */
+uint16_t KT0937Service::getCoalescedCount()
+{
+    return this->coalescedCount + this->ringCoalescedCount;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Gets the number of commands lost because the queue was full
+ */
+uint16_t KT0937Service::getOverflowCount()
+{
+    return this->overflowCount;
+}
+
+/**
+ * @ingroup GA03
+ * @brief Station memory on a byte storage
  * 
+ * @param storage      EEPROM, NVS, flash or file backend
+ * @param presetCount  number of preset slots (before the log)
+ * @param base         first byte used in the storage
+ * @param size         bytes used from base. 0 = up to the end of the storage
  */
+KT0937StationStore::KT0937StationStore(KT0937Storage &storage, uint8_t presetCount, uint16_t base, uint16_t size)
+{
+    this->storage = &storage;
+    this->base = base;
+    this->size = size;
+    this->presetCount = presetCount;
+    this->logStart = base + (uint16_t) presetCount * STATION_ENTRY_SIZE;
+}
 
-void KT0937::setIntMode(bool isRising)
+/**
+ * @ingroup GA03
+ * @brief Packs an entry into its 4 byte storage format (see STATION_ENTRY_SIZE)
+ */
+void KT0937StationStore::packEntry(const kt09xx_station_entry &entry, uint8_t *buf)
 {
-    kt09xx_softmute_5 reg0;
-    kt09xx_softmute_2 reg1;
-    
-   
-    // set Pulse mode :  positive Pulse (RISING): TUNE_INT_MODE : 0x22<6> = 1, TUNE_INT_PL:0x1F<7> = 1 
-    //                   negtive Pulse (FALLING): TUNE_INT_MODE : 0x22<6> = 1, TUNE_INT_PL:0x1F<7> = 0
+    buf[0] = entry.band;
+    buf[1] = (entry.channel >> 8) & 0x7F;                           // bit 7: marker, always 0
+    buf[2] = entry.channel & 0xFF;
+    buf[3] = ((entry.flags & 0x07) << 5) | (entry.volume & 0x1F);
+}
 
-    if(isRising == INT_MODE_RISING)
-    {        
-        reg0.raw = getRegister(REG_SOFTMUTE5);
-        reg0.refined.TUNE_INT_MODE= 1;        
-        setRegister(REG_SOFTMUTE5,reg0.raw);
+/**
+ * @ingroup GA03
+ * @brief Unpacks an entry from its 4 byte storage format
+ * @return false if the slot is erased
+ */
+bool KT0937StationStore::unpackEntry(const uint8_t *buf, kt09xx_station_entry &entry)
+{
+    if (buf[1] & 0x80)
+        return false;
+
+    entry.band = buf[0];
+    entry.channel = ((uint16_t) buf[1] << 8) | buf[2];
+    entry.flags = buf[3] >> 5;
+    entry.volume = buf[3] & 0x1F;
+    return true;
+}
 
-        reg1.raw = getRegister(REG_SOFTMUTE2);
-        reg1.refined.TUNE_INT_PL= 1;
-        setRegister(REG_SOFTMUTE2,reg1.raw);
+bool KT0937StationStore::readEntry(uint16_t address, kt09xx_station_entry &entry)
+{
+    uint8_t buf[STATION_ENTRY_SIZE];
+    return this->storage->read(address, buf, STATION_ENTRY_SIZE) && unpackEntry(buf, entry);
+}
 
-    }else if(isRising == INT_MODE_FALLING)
-    {
-        reg0.raw = getRegister(REG_SOFTMUTE5);
-        reg0.refined.TUNE_INT_MODE= 1;
-        setRegister(REG_SOFTMUTE5,reg0.raw);
+bool KT0937StationStore::writeEntry(uint16_t address, const kt09xx_station_entry &entry)
+{
+    uint8_t buf[STATION_ENTRY_SIZE];
+    packEntry(entry, buf);
+    return this->storage->write(address, buf, STATION_ENTRY_SIZE);
+}
 
-        reg1.raw = getRegister(REG_SOFTMUTE2);
-        reg1.refined.TUNE_INT_PL= 0;
-        setRegister(REG_SOFTMUTE2,reg1.raw);
-    }
+/**
+ * @ingroup GA03
+ * @brief Checks the marker of a log slot
+ * @param slot    log slot (0 ~ logSlots - 1)
+ * @param erased  receives true if the slot holds no entry
+ * @return false on a storage error
+ */
+bool KT0937StationStore::isSlotErased(uint16_t slot, bool &erased)
+{
+    uint8_t marker;
+    if (!this->storage->read(this->logStart + slot * STATION_ENTRY_SIZE + 1, &marker, 1))
+        return false;
+    erased = (marker & 0x80) != 0;
+    return true;
+}
 
-     //set INT Mode TUNE_INT_EN  0x22<7>  to 1
-     reg0.raw = getRegister(REG_SOFTMUTE5);
-     reg0.refined.TUNE_INT_EN= 1;
-     setRegister(REG_SOFTMUTE5,reg0.raw);
+/**
+ * @ingroup GA03
+ * @brief Counts the entries of a log half
+ * @details A half is written in order and erased as a whole, so its first erased slot is found with a 
+ * @details binary search: about log2(slots / 2) reads of one byte.
+ * 
+ * @param first  first slot of the half (0 or logSlots / 2)
+ * @param count  receives the number of entries
+ * @return false on a storage error
+ */
+bool KT0937StationStore::findHalfEnd(uint16_t first, uint16_t &count)
+{
+    uint16_t low = 0;
+    uint16_t high = this->logSlots / 2;
+    while (low < high)
+    {
+        uint16_t middle = low + (high - low) / 2;
+        bool erased;
+        if (!isSlotErased(first + middle, erased))
+            return false;
+        if (erased)
+            high = middle;
+        else
+            low = middle + 1;
+    }
+    count = low;
+    return true;
+}
 
-    //set INT_PIN to b(00) as auto cleard interrupt signal.
-    kt09xx_anacfg_1 reg2;
-    reg2.raw = getRegister(REG_ANACFG1);
-    reg2.refined.INT_PIN= 0;
-    setRegister(REG_ANACFG1,reg2.raw);
+/**
+ * @ingroup GA03
+ * @brief Erases a log half
+ * @param first  first slot of the half (0 or logSlots / 2)
+ */
+bool KT0937StationStore::eraseHalf(uint16_t first)
+{
+    return this->storage->erase(this->logStart + first * STATION_ENTRY_SIZE, (this->logSlots / 2) * STATION_ENTRY_SIZE);
+}
 
+/**
+ * @ingroup GA03
+ * @brief Finds the last station of the log. Call it once the storage is ready (e.g. after EEPROM.begin)
+ * @details Both halves hold entries only when a save was interrupted before the older half was erased: 
+ * @details the half that is not full then holds the newest entry. With fewer than 4 log slots (halves of 
+ * @details one entry) that case cannot be told apart and the second half is taken.
+ * @return false if the storage is too small for the presets and two log entries
+ */
+bool KT0937StationStore::begin()
+{
+    uint32_t end = this->size ? (uint32_t) this->base + this->size : this->storage->size();
+
+    this->logSlots = 0;
+    this->logLast = STATION_LOG_EMPTY;
+    if (end < (uint32_t) this->logStart + 2 * STATION_ENTRY_SIZE)
+        return false;
+    this->logSlots = ((end - this->logStart) / STATION_ENTRY_SIZE) & ~1U;
+
+    uint16_t half = this->logSlots / 2;
+    uint16_t countA, countB;
+    if (!findHalfEnd(0, countA) || !findHalfEnd(half, countB))
+        return false;
+
+    if (countB && (countA == 0 || countB < half || countA == half))
+        this->logLast = half + countB - 1;
+    else if (countA)
+        this->logLast = countA - 1;
+    return true;
 }
 
-void KT0937::enableINT()
+/**
+ * @ingroup GA03
+ * @brief Appends the station to the log
+ * @details Nothing is written when the entry equals the last one. The entry is written first; when it is 
+ * @details the first one of a half, the other half (older entries) is erased afterwards. A power loss at any 
+ * @details point leaves either the new or the previous station in the log.
+ * @return false on a storage error (or begin not called)
+ */
+bool KT0937StationStore::saveStation(const kt09xx_station_entry &entry)
 {
-    kt09xx_softmute_5 reg;
-    //set INT Mode TUNE_INT_EN  0x22<7>  to 1
-    reg.raw = getRegister(REG_SOFTMUTE5);
-    reg.refined.TUNE_INT_EN= 1;
-    setRegister(REG_SOFTMUTE5,reg.raw);
+    uint8_t current[STATION_ENTRY_SIZE];
+    uint8_t last[STATION_ENTRY_SIZE];
+
+    if (this->logSlots == 0)
+        return false;
+
+    packEntry(entry, current);
+    if (this->logLast != STATION_LOG_EMPTY 
+        && this->storage->read(this->logStart + this->logLast * STATION_ENTRY_SIZE, last, STATION_ENTRY_SIZE) 
+        && memcmp(current, last, STATION_ENTRY_SIZE) == 0)
+        return true;
+
+    uint16_t half = this->logSlots / 2;
+    uint16_t slot = (this->logLast == STATION_LOG_EMPTY) ? 0 : (this->logLast + 1) % this->logSlots;
+    uint16_t first = (slot < half) ? 0 : half;
+    uint16_t other = half - first;
+    bool erased;
+
+    //entering a half still holding entries of an interrupted round: the newest entry is in the other half
+    if (slot == first)
+    {
+        if (!isSlotErased(slot, erased))
+            return false;
+        if (!erased && !eraseHalf(first))
+            return false;
+    }
 
-    //set INT_PIN to b(00) as auto cleard interrupt signal.
-    kt09xx_anacfg_1 reg2;
-    reg2.raw = getRegister(REG_ANACFG1);
-    reg2.refined.INT_PIN= 0;
-    setRegister(REG_ANACFG1,reg2.raw);
+    if (!this->storage->write(this->logStart + slot * STATION_ENTRY_SIZE, current, STATION_ENTRY_SIZE))
+        return false;
+    this->logLast = slot;
+
+    //the newest entry is safe: the other half can go
+    if (!isSlotErased(other, erased))
+        return false;
+    return erased || eraseHalf(other);
 }
 
-void KT0937::setSWOnPin(int sw_on_pin_temp)
+/**
+ * @ingroup GA03
+ * @brief Gets the last station saved
+ * @return false if none
+ */
+bool KT0937StationStore::loadStation(kt09xx_station_entry &entry)
 {
-    this->swOnPin = sw_on_pin_temp;
+    if (this->logLast == STATION_LOG_EMPTY)
+        return false;
+    return readEntry(this->logStart + this->logLast * STATION_ENTRY_SIZE, entry);
 }
 
+/**
+ * @ingroup GA03
+ * @brief Stores a preset. The slot is erased and rewritten only if its content changes
+ * @return false if index >= presetCount or on a storage error
+ */
+bool KT0937StationStore::savePreset(uint8_t index, const kt09xx_station_entry &entry)
+{
+    uint8_t current[STATION_ENTRY_SIZE];
+    uint8_t stored[STATION_ENTRY_SIZE];
+    uint16_t address = this->base + (uint16_t) index * STATION_ENTRY_SIZE;
 
+    if (index >= this->presetCount)
+        return false;
 
+    packEntry(entry, current);
+    if (this->storage->read(address, stored, STATION_ENTRY_SIZE) && memcmp(current, stored, STATION_ENTRY_SIZE) == 0)
+        return true;
 
+    return this->storage->erase(address, STATION_ENTRY_SIZE) && this->storage->write(address, current, STATION_ENTRY_SIZE);
+}
+
+/**
+ * @ingroup GA03
+ * @brief Gets a preset
+ * @return false if index >= presetCount or the slot is empty
+ */
+bool KT0937StationStore::loadPreset(uint8_t index, kt09xx_station_entry &entry)
+{
+    if (index >= this->presetCount)
+        return false;
+    return readEntry(this->base + (uint16_t) index * STATION_ENTRY_SIZE, entry);
+}
 
+/**
+ * @ingroup GA03
+ * @brief Erases the presets and the log
+ */
+bool KT0937StationStore::clear()
+{
+    this->logLast = STATION_LOG_EMPTY;
+    return this->storage->erase(this->base, (this->logStart - this->base) + this->logSlots * STATION_ENTRY_SIZE);
+}
@@ -52,12 +52,18 @@
 #define REF_CLOCK_ENABLE    1      // Reference Clock
 #define REF_CLOCK_DISABLE   0      // Crystal Clock
 
+#define CLOCK_PLL_HZ        21888000UL  // DIVIDERN * Fpfd (Datasheet Table 10)
+#define CLOCK_PFD_HZ        32000UL     // target phase-detection frequency Fpfd = reference / DIVIDERP
+
 #define DIAL_MODE_ON        1      // Mechanical tuning (Via 100K resistor)
 #define DIAL_MODE_OFF       0      // MCU (Arduino) tuning
 
 #define INT_MODE_RISING     1       //INT pin rising signal as interrupt out.
 #define INT_MODE_FALLING    0
 
+#define FM_CHANNEL_KHZ      50      // FM channel unit (RDCHAN, LOW_CHAN, FM_HIGH_CHAN): 50kHz
+#define AM_CHANNEL_KHZ      1       // MW/SW channel unit (RDCHAN, LOW_CHAN, AM_HIGH_CHAN): 1kHz
+
 /**
 * register address 
 */
@@ -166,6 +172,229 @@
 #define ERR_POWER_ON 1
 #define ERR_CLK 2
 #define ERR_SW_PIN 3
+#define ERR_CHANGE_BAND 4
+#define ERR_BAND_RANGE 5
+#define ERR_SEEK 6
+#define ERR_CALIBRATION 7
+
+/*
+* register timing policy (see setRegister)
+*/
+#define SETTLE_ON_CHANGE    0       // applies when any bit of the mask changes
+#define SETTLE_ON_SET       1       // applies when a bit of the mask goes from 0 to 1
+
+#define STDBY_SETTLE_US         1000    // Programming Guide 11: delay 1ms after clearing STDBY before STBYLDO_PD
+#define DSP_RST_SETTLE_US       1000    // DSP reset pulse. Not documented, kept conservative
+#define CHANGE_BAND_TIMEOUT_MS  50      // CHANGE_BAND is cleared by the device when the band switch is done
+#define POWERON_TIMEOUT_MS      1000    // POWERON_FINISH is set by the device when the clock is locked
+#define CHANGE_BAND_POLL_US     500     // interval between two CHANGE_BAND polls
+#define POWERON_POLL_MS         5       // interval between two POWERON_FINISH polls. The crystal takes hundreds of ms
+
+#define SETUP_IDLE              0       // beginSetup() not called yet
+#define SETUP_STANDBY           1       // STDBY set, waiting STDBY_SETTLE_US
+#define SETUP_WAKEUP            2       // STDBY cleared, waiting STDBY_SETTLE_US
+#define SETUP_POWERON           3       // clock configured, waiting POWERON_FINISH (up to POWERON_TIMEOUT_MS)
+#define SETUP_DONE              4       // finished. See getErrorCode()
+
+#define RETAINED_KEY_COUNT      22      // key registers checked by KT0937::resume (PLLCFG0 ~ RXCFG1, FMCHAN0 ~ AMCHAN1, LOW_CHAN0 ~ CHAN_NUM1)
+
+/*
+* register map 
+*/
+#define KT0937_REG_COUNT    0xF8    // 0x00 ~ 0xF7. Size of the shadow register map kept by the KT0937 class.
+
+/*
+* burst access (see readRegisters / writeRegisters)
+* The KT0937 register address counter is incremented by one after each byte (datasheet, CURRENT ADDRESS READ).
+* Define KT0937_I2C_AUTO_INCREMENT 0 before including KT0937.h to fall back to one transaction per register.
+*/
+#ifndef KT0937_I2C_AUTO_INCREMENT
+#define KT0937_I2C_AUTO_INCREMENT   1
+#endif
+#define KT0937_BURST_MAX    30      // data bytes per I2C transaction. Fits the 32 bytes AVR Wire buffer with the register address.
+
+/*
+* I2C bus clock (see KT0937::setI2CBus). The bus is initialised once, at the first register access.
+*/
+#define I2C_CLOCK_100KHZ    100000UL    // Standard-mode
+#define I2C_CLOCK_400KHZ    400000UL    // Fast-mode
+#define I2C_CLOCK_1MHZ      1000000UL   // Fast-mode Plus. Beyond the datasheet figures: check it on your board
+#ifndef KT0937_I2C_CLOCK
+#define KT0937_I2C_CLOCK    I2C_CLOCK_100KHZ
+#endif
+
+/*
+* command queue (see KT0937::poll). Each entry costs 5 bytes of RAM on AVR, 8 on 32 bits MCUs.
+*/
+#ifndef KT0937_QUEUE_SIZE
+#define KT0937_QUEUE_SIZE   24
+#endif
+#define COMMAND_WRITE       0       // masked register write
+#define COMMAND_CALLBACK    1       // completion callback
+#define COMMAND_BAND_STATE  2       // internal: currentMode and seek range of a queued band (see KT0937::queueBand)
+
+/*
+* tuning events (see KT0937::onTuneInterrupt / KT0937::serviceTuneEvents)
+*/
+#ifndef KT0937_EVENT_SIZE
+#define KT0937_EVENT_SIZE       8       // ISR to loop ring buffer entries. Power of 2
+#endif
+static_assert((KT0937_EVENT_SIZE & (KT0937_EVENT_SIZE - 1)) == 0, "KT0937_EVENT_SIZE must be a power of 2");
+#ifndef KT0937_EVENT_QUIET_US
+#define KT0937_EVENT_QUIET_US   20000   // a burst of dial interrupts is serviced once the dial has been quiet for this long
+#endif
+
+/*
+* telemetry (see KT0937::pollTelemetry)
+* The status block is sampled every TELEMETRY_FAST_MS after a tune, then the interval doubles after each sample 
+* without change, up to TELEMETRY_SLOW_MS. A metric changes when it leaves the hysteresis band around the value 
+* reported last.
+*/
+#ifndef TELEMETRY_FAST_MS
+#define TELEMETRY_FAST_MS           100     // sampling interval after a tune or a change
+#endif
+#ifndef TELEMETRY_SLOW_MS
+#define TELEMETRY_SLOW_MS           2000    // sampling interval once the signal is stable
+#endif
+#define TELEMETRY_RSSI_HYSTERESIS   3       // dB
+#define TELEMETRY_SNR_HYSTERESIS    2
+#define TELEMETRY_CHANNEL           0x01    // changed metrics passed to the telemetry callback
+#define TELEMETRY_RSSI              0x02
+#define TELEMETRY_SNR               0x04
+#define TELEMETRY_STEREO            0x08
+#define TELEMETRY_VALID             0x10
+
+/*
+* signal history (see KT0937::getSignalStats)
+* RSSI and SNR samples read by getRSSI, getSNR, getFMRSSI... and readStatus are kept per mode (FM, AM) in a ring 
+* buffer, with an exponential moving average. Integer arithmetic only. Costs 4 * (KT0937_HISTORY_SIZE + 4) bytes.
+*/
+#ifndef KT0937_HISTORY_SIZE
+#define KT0937_HISTORY_SIZE     8       // samples kept per metric and mode. 1 ~ 32
+#endif
+#ifndef SIGNAL_EMA_SHIFT
+#define SIGNAL_EMA_SHIFT        2       // weight of a new sample in the average: 1 / 2^SIGNAL_EMA_SHIFT
+#endif
+#define SIGNAL_RSSI             0       // metric of getSignalStats
+#define SIGNAL_SNR              1
+
+/*
+* RSSI units and calibration (see KT0937::getRSSILevel / KT0937::calibrateRSSI)
+* Raw RSSI register values convert as dBuVEMF = RSSI + 3; dBuV = RSSI - 3; dBm = RSSI - 110.
+* Once set (setRSSIBias / calibrateRSSI), the bias of each receiver path is programmed into FM_RSSI_BIAS (DSPCFG6) 
+* or AM_RSSI_BIAS (AMDSP1) at each band switch, so the RSSI reported by the device is already corrected.
+*/
+#define RSSI_UNIT_DBUVEMF       0
+#define RSSI_UNIT_DBUV          1
+#define RSSI_UNIT_DBM           2
+#define RSSI_DBUVEMF_OFFSET     3       // raw RSSI to dBuVEMF
+#define RSSI_DBUV_OFFSET        (-3)    // raw RSSI to dBuV
+#define RSSI_DBM_OFFSET         (-110)  // raw RSSI to dBm
+#define RSSI_BIAS_MIN           (-16)   // dB. FM_RSSI_BIAS / AM_RSSI_BIAS range
+#define RSSI_BIAS_MAX           15
+#define RSSI_BIAS_MASK          0x1F    // FM_RSSI_BIAS / AM_RSSI_BIAS bits (5 bit two's complement)
+#define CALIBRATION_FM          0       // receiver paths with their own RSSI bias
+#define CALIBRATION_MW          1
+#define CALIBRATION_SW          2
+#define CALIBRATION_BAND_COUNT  3
+#define CALIBRATION_SAMPLES     8       // RSSI readings averaged by calibrateRSSI
+#define CALIBRATION_SAMPLE_MS   10      // time between two of them
+
+/*
+* radio service (see KT0937Service)
+* Command types, in priority order: a pending command of a lower type runs first.
+*/
+#define SERVICE_MUTE            0       // setMute
+#define SERVICE_VOLUME          1       // setVolume
+#define SERVICE_TUNE            2       // setChannel. Runs after a band switch posted before it
+#define SERVICE_BAND            3       // setBand. Drops the tune commands posted before it
+#define SERVICE_STATUS          4       // readStatus, delivered to the onStatus callback (telemetry)
+#define SERVICE_COMMAND_COUNT   5
+#ifndef KT0937_SERVICE_QUEUE_SIZE
+#define KT0937_SERVICE_QUEUE_SIZE   8       // commands posted and not yet picked up by the service
+#endif
+#ifndef KT0937_SERVICE_STACK
+#define KT0937_SERVICE_STACK        3072    // service task stack (FreeRTOS stack units)
+#endif
+
+/*
+* seek and scan (see KT0937::seekUp / KT0937::scanBand)
+*/
+#define SEEK_DOWN               0
+#define SEEK_UP                 1
+#define SEEK_SETTLE_MS          2       // after CHANGE_BAND is cleared, before the first status read of a channel
+#define SEEK_DWELL_MS           25      // extra time given to VALID_TUNE when the RSSI is close to the threshold
+#define SEEK_RSSI_MARGIN        6       // a channel this far (dB) below the RSSI low threshold is skipped at once
+#define SWEEP_SETTLE_US         1000    // spectrum sweep: CHANGE_BAND cleared to RSSI read (see KT0937::sweep)
+
+/*
+* station memory (see KT0937StationStore)
+* On-storage entry, 4 bytes: band id<7:0> | marker(0), channel<14:8> | channel<7:0> | flags<2:0>, volume<4:0>
+* The marker bit is 0 in every written entry, so an erased slot (0xFF) never reads as a station.
+*/
+#define STATION_ENTRY_SIZE      4
+#define STATION_FLAG_CHANNEL    0x01    // channel tuned by the MCU (setChannel / seek). 0 = the dial sets the channel
+#define STATION_FLAG_USER1      0x02    // free for the application
+#define STATION_FLAG_USER2      0x04    // free for the application
+#define STATION_LOG_EMPTY       0xFFFF  // no station in the log
+
+#if defined(ESP32) || defined(ESP8266)
+#define KT0937_ISR_ATTR IRAM_ATTR
+#else
+#define KT0937_ISR_ATTR
+#endif
+
+/*
+* I2C tracer (see KT0937::dumpTrace / KT0937::dumpRegisterHistogram)
+* Define KT0937_TRACE 1 before including KT0937.h to record every register access (address, direction, value, 
+* micros()) in a ring buffer of KT0937_TRACE_SIZE entries and count the reads and writes of each register. 
+* Costs KT0937_TRACE_SIZE * 8 + 992 bytes of RAM. With KT0937_TRACE 0 (default) nothing is compiled in.
+*/
+#ifndef KT0937_TRACE
+#define KT0937_TRACE        0
+#endif
+#ifndef KT0937_TRACE_SIZE
+#define KT0937_TRACE_SIZE   32
+#endif
+#define TRACE_READ          0
+#define TRACE_WRITE         1
+
+#if KT0937_TRACE
+#define KT0937_TRACE_ACCESS(reg, value, direction) traceAccess(reg, value, direction)
+#else
+#define KT0937_TRACE_ACCESS(reg, value, direction) ((void) 0)
+#endif
+
+/*
+* locking policy (see KT0937Lock / KT0937::beginTransaction)
+* Define KT0937_LOCK before including KT0937.h to share one KT0937 object between tasks or cores:
+*   KT0937_LOCK_NONE      no lock, nothing compiled in (default, single thread sketches)
+*   KT0937_LOCK_FREERTOS  FreeRTOS recursive mutexes (ESP32, RP2040, STM32 with FreeRTOS...)
+*   KT0937_LOCK_STD       std::recursive_mutex (host builds)
+* Two locks: the config lock makes each API call an atomic transaction (read-modify-write, band switch,
+* seek...); the bus lock is held for one I2C transaction only. Status reads (RSSI, SNR, channel, readStatus)
+* take the bus lock alone, so they never wait behind a band switch or a seek.
+*/
+#define KT0937_LOCK_NONE        0
+#define KT0937_LOCK_FREERTOS    1
+#define KT0937_LOCK_STD         2
+#ifndef KT0937_LOCK
+#define KT0937_LOCK             KT0937_LOCK_NONE
+#endif
+
+#if KT0937_LOCK == KT0937_LOCK_FREERTOS
+#if defined(ESP32)
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#else
+#include <FreeRTOS.h>
+#include <semphr.h>
+#include <task.h>
+#endif
+#elif KT0937_LOCK == KT0937_LOCK_STD
+#include <mutex>
+#endif
 
 /*
 * MW IF BandWidth
@@ -177,6 +406,22 @@
 #define AM_IF_4_8KHZ 3
 #define AM_IF_6_0KHZ 4
 
+/*
+* Band space (channel step) codes. FM_SPACE, MW_SPACE and SW_SPACE
+*/
+#define FM_SPACE_200KHZ     0
+#define FM_SPACE_100KHZ     1
+#define FM_SPACE_50KHZ      2
+#define MW_SPACE_1KHZ       0
+#define MW_SPACE_9KHZ       1
+#define MW_SPACE_10KHZ      2
+#define SW_SPACE_1KHZ       0
+#define SW_SPACE_5KHZ       1
+#define SW_SPACE_9KHZ       2
+#define SW_SPACE_10KHZ      3
+
+#define BAND_REG_COUNT      14      // registers written by a band switch (see KT0937::setBand)
+
 
 
 
@@ -2119,6 +2364,304 @@ typedef union {
 
 
 
+/**
+ * @ingroup GA01
+ * @brief Register timing policy entry 
+ * @details Describes the settle time a register write needs before the device can be accessed again.
+ * @details When flagMask is not 0, the write is followed by polling flagReg until (flagReg & flagMask) == flagState 
+ * @details or timeoutMs expires. Plain config registers have no entry and get no delay at all.
+ */
+typedef struct {
+    uint8_t reg;            //!< Register address
+    uint8_t mask;           //!< Bits of reg that trigger the policy
+    uint8_t edge;           //!< SETTLE_ON_CHANGE or SETTLE_ON_SET
+    uint16_t settleUs;      //!< Fixed delay after the write (microseconds)
+    uint8_t flagReg;        //!< Readiness flag register
+    uint8_t flagMask;       //!< Readiness flag bits (0 = no readiness flag)
+    uint8_t flagState;      //!< Value of the flag bits when the device is ready
+    uint16_t timeoutMs;     //!< Maximum time waiting for the readiness flag
+    uint16_t pollUs;        //!< Interval between two readiness flag reads (microseconds)
+    uint8_t errorCode;      //!< errorCode set on timeout
+} kt09xx_timing_policy;
+
+/**
+ * @ingroup GA01
+ * @brief Completion callback of the command queue. See KT0937::queueCallback
+ * @param tag        value given to queueCallback (e.g. the band number)
+ * @param errorCode  KT0937::getErrorCode() when the callback runs (ERR_OK, ERR_CHANGE_BAND...)
+ */
+typedef void (*kt09xx_command_callback)(uint8_t tag, uint8_t errorCode);
+
+/**
+ * @ingroup GA01
+ * @brief Channel changed callback. See KT0937::onChannelChanged
+ * @param frequency  kHz
+ * @param rssi       dBuVEMF (see getRSSI)
+ * @param snr        SNR (see getSNR)
+ */
+typedef void (*kt09xx_channel_callback)(uint32_t frequency, uint8_t rssi, uint8_t snr);
+
+/**
+ * @ingroup GA01
+ * @brief Command queue entry. See KT0937::poll
+ */
+typedef struct {
+    uint8_t type;                       //!< COMMAND_WRITE, COMMAND_CALLBACK or COMMAND_BAND_STATE
+    uint8_t reg;                        //!< COMMAND_WRITE: register number; COMMAND_CALLBACK: tag
+    uint8_t value;                      //!< COMMAND_WRITE: bits to write
+    uint8_t mask;                       //!< COMMAND_WRITE: bits of value written. The others keep the register content
+    kt09xx_command_callback callback;   //!< COMMAND_CALLBACK: function called
+} kt09xx_command;
+
+/**
+ * @ingroup GA01
+ * @brief Signal status snapshot 
+ * @details Filled by KT0937::readStatus from one burst read of the status block (STATUS0 ~ AMSTATUS3, 0xDE ~ 0xED).
+ * @details RSSI and SNR are the raw register values. FM RSSI(dBuVEMF) = fmRSSI + 3; AM RSSI(dBm) = -110 + amRSSI.
+ */
+typedef struct {
+    uint16_t channel;           //!< RDCHAN<14:0> (STATUS6/7). FM: 50kHz units; MW/SW: 1kHz units
+    uint8_t fmRSSI;             //!< FM_RSSI<6:0> (STATUS8)
+    uint8_t fmSNR;              //!< FM_SNR<5:0> (STATUS4)
+    uint8_t amRSSI;             //!< AM_RSSI<6:0> (AMSTATUS0)
+    uint8_t amSNR;              //!< AM_SNR_MODE1<6:0> (AMSTATUS2)
+    uint8_t smuteGain;          //!< SMUTE_GAIN<7:0> (STATUS5). 0x80 = 0dB, see Programming Guide appendix
+    int8_t fmCarrierOffset;     //!< FM_CARRIER_OFST (AFC_STATUS1). 1024Hz units
+    int8_t amCarrierOffset;     //!< AM_CARRIER_OFST (AFC_STATUS0). 128Hz units
+    uint8_t stereo : 1;         //!< ST_TUNE (STATUS0). 1 = Stereo state
+    uint8_t valid : 1;          //!< VALID_TUNE (STATUS0). 1 = Valid channel
+    uint8_t amCarrierLock : 1;  //!< AM_CARRY_LOCK (AMSTATUS3)
+    uint8_t reserved : 5;
+} kt09xx_signal_status;
+
+/**
+ * @ingroup GA01
+ * @brief Sample history of one metric (RSSI or SNR) in one mode. See KT0937::getSignalStats
+ */
+typedef struct {
+    uint8_t sample[KT0937_HISTORY_SIZE];    //!< ring buffer. The oldest sample is overwritten
+    uint8_t head;                           //!< next entry written
+    uint8_t count;                          //!< valid samples
+    uint16_t ema;                           //!< exponential moving average, 8.8 fixed point
+} kt09xx_signal_history;
+
+/**
+ * @ingroup GA01
+ * @brief Statistics of the sample history of one metric. Same unit as the getter (RSSI: dBuVEMF)
+ */
+typedef struct {
+    uint8_t last;               //!< newest sample
+    uint8_t min;
+    uint8_t max;
+    uint8_t mean;               //!< rounded
+    uint8_t median;             //!< rounded mean of the two middle samples if count is even
+    uint8_t ema;                //!< exponential moving average, rounded
+    uint8_t count;              //!< samples in the history
+} kt09xx_signal_stats;
+
+/**
+ * @ingroup GA01
+ * @brief Station found by KT0937::seekUp, KT0937::seekDown or KT0937::scanBand (4 bytes)
+ */
+typedef struct {
+    uint16_t channel;           //!< RDCHAN units. FM: 50kHz; MW/SW: 1kHz
+    uint8_t rssi;               //!< raw RSSI, FM_RSSI or AM_RSSI. dBm = rssi - 110
+    uint8_t snr;                //!< raw SNR, FM_SNR or AM_SNR_MODE1
+} kt09xx_station;
+
+/**
+ * @ingroup GA01
+ * @brief Station memory entry (band, channel, volume and flags). Stored in 4 bytes, see STATION_ENTRY_SIZE
+ */
+typedef struct {
+    uint8_t band;               //!< band id, defined by the application (e.g. index in its band table)
+    uint16_t channel;           //!< RDCHAN<14:0>. FM: 50kHz units; MW/SW: 1kHz units
+    uint8_t volume;             //!< 0 ~ 31
+    uint8_t flags;              //!< STATION_FLAG_*
+} kt09xx_station_entry;
+
+/**
+ * @ingroup GA01
+ * @brief Band descriptor 
+ * @details Everything a band switch writes into the device. Build it with makeBand so CH_ADC_WIN is computed 
+ * @details at compile time, and apply it with KT0937::setBand.
+ */
+typedef struct {
+    uint16_t lowChannel;        //!< LOW_CHAN<14:0>. FM: frequency / 50kHz; MW/SW: frequency / 1kHz
+    uint16_t highChannel;       //!< FM_HIGH_CHAN<11:0> (FM) or AM_HIGH_CHAN<14:0> (MW/SW)
+    uint16_t channelNumber;     //!< CHAN_NUM<11:0>. (high frequency - low frequency) / step
+    uint16_t chAdcWin;          //!< CH_ADC_WIN<12:0> = (CHAN_NUM<11:0> + CH_GUARD<7:0>) * 2
+    uint8_t space;              //!< FM_SPACE, MW_SPACE or SW_SPACE code. See FM_SPACE_100KHZ, MW_SPACE_9KHZ, SW_SPACE_5KHZ...
+    uint8_t guard;              //!< CH_GUARD<7:0>
+    uint8_t mode;               //!< AM_FM. MODE_FM or MODE_AM
+    uint8_t swEnable;           //!< SW_EN. 1 = Short Wave (space is a SW_SPACE code)
+} kt09xx_band;
+
+/**
+ * @ingroup GA01
+ * @brief Builds a band descriptor. CH_ADC_WIN is derived from channelNumber and guard.
+ * @details constexpr: descriptors built from constants cost nothing at run time.
+ */
+constexpr kt09xx_band makeBand(uint16_t lowChannel, uint16_t highChannel, uint16_t channelNumber, uint8_t space, uint8_t guard, uint8_t mode, uint8_t swEnable)
+{
+    return { lowChannel, highChannel, channelNumber, (uint16_t) ((channelNumber + guard) * 2), space, guard, mode, swEnable };
+}
+
+/**
+ * @ingroup GA01
+ * @brief Builds a SW band descriptor with frequency step 1kHz (the one used by KT0937::setSWBand(low, high, chanNumber))
+ * @param lowFrequency   low band edge (kHz)
+ * @param highFrequency  high band edge (kHz)
+ * @param chanNumber     number of channels. (highFrequency - lowFrequency) / 1kHz
+ */
+constexpr kt09xx_band makeSWBand(uint16_t lowFrequency, uint16_t highFrequency, uint16_t chanNumber)
+{
+    return makeBand(lowFrequency, highFrequency, chanNumber, SW_SPACE_1KHZ, 0x17, MODE_AM, 1);
+}
+
+/**
+ * @ingroup GA01
+ * @brief Built-in bands used by setFMBand(), setAMBand() and setSWBand()
+ */
+static const kt09xx_band KT0937_FM_BAND = makeBand(1700, 2160, 230, FM_SPACE_100KHZ, 0x17, MODE_FM, 0);    // 85.0 ~ 108.0MHz, 100kHz
+static const kt09xx_band KT0937_MW_BAND = makeBand(522, 1602, 122, MW_SPACE_9KHZ, 0x17, MODE_AM, 0);       // 522 ~ 1602kHz, 9kHz
+static const kt09xx_band KT0937_SW_BAND = makeBand(9000, 10000, 200, SW_SPACE_5KHZ, 0x17, MODE_AM, 1);     // 9000 ~ 10000kHz, 5kHz
+
+/**
+ * @ingroup GA01
+ * @brief Clock profile 
+ * @details PLL dividers and phase-detection frequency of a reference clock. Build it with makeClockProfile.
+ */
+typedef struct {
+    uint16_t dividerP;          //!< DIVIDERP<10:0>
+    uint16_t dividerN;          //!< DIVIDERN<10:0>
+    uint32_t fpfd;              //!< FPFD<19:0> = Fpfd * 16
+    uint8_t refClockRequired;   //!< 1 = the source can only be an external reference clock (RCLK_EN = 1)
+} kt09xx_clock_profile;
+
+/**
+ * @ingroup GA01
+ * @brief Builds a clock profile for a given DIVIDERP. See makeClockProfile
+ */
+constexpr kt09xx_clock_profile makeClockProfileP(uint32_t refHz, uint16_t dividerP, uint8_t refClockRequired)
+{
+    return { dividerP,
+             (uint16_t) (((uint64_t) CLOCK_PLL_HZ * dividerP + refHz / 2) / refHz),
+             (uint32_t) ((refHz * 16 + dividerP / 2) / dividerP),
+             refClockRequired };
+}
+
+/**
+ * @ingroup GA01
+ * @brief Builds a clock profile for a given reference frequency
+ * @details DIVIDERP = reference / 32kHz (at least 1), DIVIDERN = 21.888MHz / Fpfd and FPFD = Fpfd * 16. 
+ * @details E.g. 32.768kHz: P = 1, N = 0x29C, FPFD = 0x80000; 12MHz: P = 0x177, N = 0x2AC, FPFD = 0x7D000. 
+ * @details constexpr: the dividers of a constant reference are computed at compile time.
+ * @param refHz             reference frequency (Hz)
+ * @param refClockRequired  1 = the source can only be an external reference clock (MHz references)
+ */
+constexpr kt09xx_clock_profile makeClockProfile(uint32_t refHz, uint8_t refClockRequired)
+{
+    return makeClockProfileP(refHz, ((refHz + CLOCK_PFD_HZ / 2) / CLOCK_PFD_HZ) ? (uint16_t) ((refHz + CLOCK_PFD_HZ / 2) / CLOCK_PFD_HZ) : 1, refClockRequired);
+}
+
+/**
+ * @ingroup GA01
+ * @brief Band register image 
+ * @details Content of the band registers (BANDCFG0, BANDCFG2, BANDCFG3, ADC3, ADC4, FMCHAN0, FMCHAN1, AMCHAN0, 
+ * @details AMCHAN1, LOW_CHAN0, LOW_CHAN1, CHAN_NUM0, CHAN_NUM1 and GUARD2, in this order) for a given band. 
+ * @details Compute it once with KT0937::getBandImage and switch to it with KT0937::setBand. 
+ * @details Only the bits owned by the band are applied, so an image stays valid when other fields of these 
+ * @details registers change later.
+ */
+typedef struct {
+    uint8_t reg[BAND_REG_COUNT];
+} kt09xx_band_image;
+
+/**
+ * @ingroup GA01
+ * @brief Command posted to KT0937Service
+ */
+typedef struct {
+    uint8_t type;                       //!< SERVICE_MUTE ~ SERVICE_STATUS
+    union {
+        uint8_t value;                  //!< SERVICE_MUTE: 1 = mute; SERVICE_VOLUME: 0 ~ 31
+        uint16_t channel;               //!< SERVICE_TUNE: channel (see KT0937::setChannel)
+        kt09xx_band_image image;        //!< SERVICE_BAND: band register image (see KT0937::getBandImage)
+    };
+} kt09xx_service_command;
+
+/**
+ * @ingroup GA01
+ * @brief Status callback of KT0937Service (SERVICE_STATUS). See KT0937Service::onStatus
+ * @param status  snapshot read by KT0937::readStatus
+ */
+typedef void (*kt09xx_status_callback)(const kt09xx_signal_status &status);
+
+/**
+ * @ingroup GA01
+ * @brief Telemetry callback. See KT0937::onTelemetry
+ * @param status   snapshot read by KT0937::readStatus
+ * @param changed  metrics that have changed since the last callback: TELEMETRY_CHANNEL, TELEMETRY_RSSI...
+ */
+typedef void (*kt09xx_telemetry_callback)(const kt09xx_signal_status &status, uint8_t changed);
+
+/**
+ * @ingroup GA01
+ * @brief I2C tracer entry. See KT0937_TRACE
+ */
+typedef struct {
+    uint32_t timestamp;         //!< micros() at the access
+    uint8_t reg;                //!< register number
+    uint8_t value;              //!< register content read or written
+    uint8_t direction;          //!< TRACE_READ or TRACE_WRITE
+} kt09xx_trace_entry;
+
+/**
+ * @ingroup GA01
+ * @brief Recursive lock selected by KT0937_LOCK. Empty with KT0937_LOCK_NONE
+ * @details Recursive, so a locked API call can call other locked API calls (setFMBand -> setBand -> setRegister).
+ */
+class KT0937Lock
+{
+#if KT0937_LOCK == KT0937_LOCK_FREERTOS
+protected:
+    SemaphoreHandle_t mutex;
+
+public:
+    KT0937Lock() { this->mutex = xSemaphoreCreateRecursiveMutex(); }
+    void lock() { xSemaphoreTakeRecursive(this->mutex, portMAX_DELAY); }
+    void unlock() { xSemaphoreGiveRecursive(this->mutex); }
+#elif KT0937_LOCK == KT0937_LOCK_STD
+protected:
+    std::recursive_mutex mutex;
+
+public:
+    void lock() { this->mutex.lock(); }
+    void unlock() { this->mutex.unlock(); }
+#else
+public:
+    void lock() {}
+    void unlock() {}
+#endif
+};
+
+/**
+ * @ingroup GA01
+ * @brief Holds a KT0937Lock for the lifetime of the object (NULL = no lock)
+ */
+class KT0937LockGuard
+{
+protected:
+    KT0937Lock *held;
+
+public:
+    KT0937LockGuard(KT0937Lock *lock) : held(lock) { if (lock) lock->lock(); }
+    ~KT0937LockGuard() { if (this->held) this->held->unlock(); }
+    KT0937LockGuard(const KT0937LockGuard &) = delete;
+    KT0937LockGuard &operator=(const KT0937LockGuard &) = delete;
+};
+
 /**
  * @ingroup GA01
  * @brief Converts 16 bits word to two bytes
@@ -2146,6 +2689,10 @@ protected:
     int deviceAddress = KT0937_I2C_ADDRESS;
     int swOnPin = -1; 
 
+    TwoWire *wire = &Wire;                                  //!< I2C controller (see setI2CBus)
+    uint32_t i2cClock = KT0937_I2C_CLOCK;                   //!< I2C bus clock (Hz)
+    bool wireStarted = false;                               //!< true = begin() and setClock() already called on wire
+
     uint8_t currentAmSpace = 0;
     uint8_t currentFmSpace = 2;
 
@@ -2166,39 +2713,173 @@ protected:
     uint8_t currentSNR;
 
     uint8_t currentVolume = 15;
+    bool muted = false;                                     //!< true = VOLUME is 0 until setMute(false). See setMute
 
     uint8_t errorCode = ERR_OK;
+
+    uint8_t setupState = SETUP_IDLE;                        //!< beginSetup()/pollSetup() state. See SETUP_*
+    uint32_t setupTimer;                                    //!< micros() when the current setup state started
+    bool deferTimingPolicy = false;                         //!< true = setRegister does not wait (the caller handles the timing)
+    bool suspended = false;                                 //!< true = suspend() called, resume() not yet
+    uint16_t suspendChecksum;                               //!< checksum of the key registers at suspend()
+
+    uint8_t shadowRegister[KT0937_REG_COUNT];               //!< Write-through copy of the config registers (see getCachedRegister)
+    uint8_t shadowValid[KT0937_REG_COUNT / 8] = {0};        //!< One bit per register. 1 = shadowRegister holds the chip content
+
+    KT0937Lock configLock;                                  //!< shadow map, command queue and multi-register transactions (see KT0937_LOCK)
+    KT0937Lock busLock;                                     //!< one I2C transaction. Never held while taking configLock
+
+    bool isStatusRegister(int reg);
+    bool isStatusRange(int start, uint8_t n);
+    bool isShadowValid(int reg);
+    bool isShadowEqual(int reg, uint8_t value);
+    void updateShadow(int reg, uint8_t value);
+    uint8_t getTriggerMask(int reg);
+    void applyTimingPolicy(int reg, uint8_t previous, uint8_t parameter);
+    void writeRegisterImage(const uint8_t *regs, const uint8_t *image, uint8_t n);
+    void beginWire();
+    void readRegistersRaw(int start, uint8_t *buf, uint8_t n);
+    void getRetainedKey(uint8_t *key, bool fromDevice);
+    void restoreRegisters();
+
+    kt09xx_command commandQueue[KT0937_QUEUE_SIZE];         //!< command queue ring buffer (see poll)
+    uint8_t queueHead = 0;                                  //!< next free entry
+    uint8_t queueTail = 0;                                  //!< next entry to run
+    uint8_t queueCount = 0;                                 //!< number of entries waiting
+    bool queueWaiting = false;                              //!< true = the last write is settling
+    uint32_t queueWaitStart;                                //!< micros() at the last write
+    uint32_t queueSettleUs;                                 //!< settling time of the last write
+    const kt09xx_timing_policy *queueFlagPolicy;            //!< readiness flag to be polled after the last write (NULL = none)
+
+    bool pushCommand(uint8_t type, uint8_t reg, uint8_t value, uint8_t mask, kt09xx_command_callback callback);
+    bool pollTimingPolicy();
+
+    volatile uint32_t tuneEventTime[KT0937_EVENT_SIZE];     //!< micros() of the tuning interrupts (ISR to loop ring buffer)
+    volatile uint8_t tuneEventHead = 0;                     //!< next free entry. Written by onTuneInterrupt only
+    volatile uint8_t tuneEventTail = 0;                     //!< next entry to service. Written by serviceTuneEvents only
+    volatile uint8_t tuneEventOverflow = 0;                 //!< interrupts lost because the ring buffer was full. Written by onTuneInterrupt only
+    volatile uint8_t tuneEventOverflowSeen = 0;             //!< tuneEventOverflow at the last service. Written by serviceTuneEvents only
+    kt09xx_channel_callback channelChangedCallback = NULL;  //!< see onChannelChanged
+    uint16_t lastEventChannel = 0xFFFF;                     //!< channel delivered by the last callback
+
+    kt09xx_telemetry_callback telemetryCallback = NULL;     //!< see onTelemetry
+    kt09xx_signal_status telemetryReported;                 //!< snapshot passed to the last telemetry callback
+    uint8_t telemetryReportedMode = 0xFF;                   //!< currentMode at the last callback (0xFF = none yet)
+    uint8_t telemetryRSSIHysteresis = TELEMETRY_RSSI_HYSTERESIS;
+    uint8_t telemetrySNRHysteresis = TELEMETRY_SNR_HYSTERESIS;
+    uint16_t telemetryFastMs = TELEMETRY_FAST_MS;
+    uint16_t telemetrySlowMs = TELEMETRY_SLOW_MS;
+    uint16_t telemetryIntervalMs = TELEMETRY_FAST_MS;       //!< current sampling interval
+    uint32_t telemetryTime = 0;                             //!< millis() of the last sample
+    volatile bool telemetryKick = false;                    //!< a tune happened: back to TELEMETRY_FAST_MS
+
+    uint8_t getTelemetryChanges(const kt09xx_signal_status &status);
+
+    kt09xx_signal_history signalHistory[2][2] = {};         //!< [MODE_FM / MODE_AM][SIGNAL_RSSI / SIGNAL_SNR]
+    volatile bool signalHistoryStale = false;               //!< a tune happened: the history is cleared at the next sample
+
+    void recordSignal(uint8_t mode, uint8_t metric, uint8_t value);
+
+    int8_t rssiBias[CALIBRATION_BAND_COUNT] = {0};          //!< dB, per receiver path. See setRSSIBias
+    bool rssiBiasEnabled = false;                           //!< true once setRSSIBias has been called: band switches program the bias
+
+    uint8_t getCalibrationBand();
+    void applyRSSIBias(uint8_t calibrationBand);
+
+    uint16_t bandLowChannel = 0;                            //!< low edge of the last band set with setBand (seek / scan range)
+    uint16_t bandHighChannel = 0;                           //!< high edge of the last band set with setBand (seek / scan range)
+
+    void setBandRange(const uint8_t *image);
+    const uint8_t *mergeBandImage(const kt09xx_band_image &bandImage, uint8_t *image);
+    void saveBandRegisters(uint8_t *image);
+    void restoreBandRegisters(const uint8_t *image);
+    void loadBandState();
+    void setCurrentMode(uint8_t mode);
+    uint8_t readCurrentMode();
+    uint8_t getSeekRSSIThreshold();
+    bool probeChannel(uint16_t channel, kt09xx_station &station);
+    bool seek(uint8_t direction, kt09xx_station *station);
+    uint8_t prepareChannel(uint16_t channel);
+    void readSweepSample(uint8_t *rssi, uint8_t *snr);
+
+#if KT0937_TRACE
+    kt09xx_trace_entry traceBuffer[KT0937_TRACE_SIZE];      //!< I2C tracer ring buffer
+    uint8_t traceHead = 0;                                  //!< next entry to be written
+    uint8_t traceCount = 0;                                 //!< number of valid entries
+    uint16_t traceReads[KT0937_REG_COUNT] = {0};            //!< reads per register (saturated at 0xFFFF)
+    uint16_t traceWrites[KT0937_REG_COUNT] = {0};           //!< writes per register (saturated at 0xFFFF)
+
+    void traceAccess(int reg, uint8_t value, uint8_t direction);
+#endif
     
 
 public:
     void setRegister(int reg, uint8_t parameter);  // reg ADDRESS , parameter to write to the register
     uint8_t getRegister(int reg);
+    uint8_t getCachedRegister(int reg);
+    void readRegisters(int start, uint8_t *buf, uint8_t n);
+    void writeRegisters(int start, const uint8_t *buf, uint8_t n);
+    void getCachedRegisters(int start, uint8_t *buf, uint8_t n);
+    void invalidateRegisterCache();
+    bool waitRegisterFlag(int reg, uint8_t mask, uint8_t state, uint16_t timeoutMs, uint16_t pollUs);
     uint16_t getDeviceId();
     void setI2CBusAddress(int deviceAddress);
+    void setI2CBus(TwoWire &wire, uint32_t clock = KT0937_I2C_CLOCK);
+    void beginTransaction();
+    void endTransaction();
 
     void enableSWAmp(uint8_t on_off); //9018 RF Amplifier
-    void setSystemClock(); // set SystemClock to 32.768 crystal
-    void setup();//init KT0937
-    void setup(uint8_t swOnPin);
+    void setReferenceClockType(uint8_t type, uint8_t refClockEnabled);
+    void setSystemClock(); // set SystemClock according to setReferenceClockType (default 32.768kHz crystal)
+    uint8_t setup();//init KT0937
+    uint8_t setup(uint8_t swOnPin);
+    void beginSetup();
+    bool pollSetup();
     void setVolume(int8_t volume);
     uint8_t getVolume();
+    void setMute(bool mute);
+    bool isMuted();
     void enableStandbyMode();
     void wakeUp();
+    void suspend();
+    uint8_t resume();
     void resetDSP();
     uint8_t getErrorCode();
     void setSWOnPin(int sw_on_pin);
 
     void shutDownADCCH();
     void turnOnADCCH();
-    void setADCCHWin();
+    void setADCCHWin(uint16_t chAdcWin);
+    void setChannelRange(uint16_t lowChannel, uint16_t channelNumber);
+    void setFMHighChannel(uint16_t highChannel);
+    void setAMHighChannel(uint16_t highChannel);
+    uint8_t getFMSpaceKHz();
+    uint8_t getMWSpaceKHz();
+    void getBandImage(const kt09xx_band &band, kt09xx_band_image &image);
+    void setBand(const kt09xx_band_image &image);
+    void setBand(const kt09xx_band &band);
     void setFMBand(uint16_t lowFrequency, uint16_t highFrequency);
-    void setFMBand(uint16_t singleFrequency);
+    void setFMBand(uint16_t frequency);
     void setFMBand();
     void setAMBand(uint16_t lowFrequency, uint16_t highFrequency);
     void setAMBand();
     void setSWBand(uint16_t lowFrequency, uint16_t highFrequency, uint16_t chanNumber );
     void setSWBand();
     void enableSW(uint8_t enable_sw);
+    uint16_t getChannelStep();
+    void setChannel(uint16_t channel);
+
+    void setFMTuneValid(uint8_t snrLow, uint8_t snrHigh, uint8_t rssiLow, uint8_t rssiHigh);
+    void setMWTuneValid(uint8_t snrLow, uint8_t snrHigh, uint8_t rssiLow, uint8_t rssiHigh);
+    void setSWTuneValid(uint8_t snrLow, uint8_t snrHigh, uint8_t rssiLow, uint8_t rssiHigh);
+    bool seekUp(kt09xx_station *station = NULL);
+    bool seekDown(kt09xx_station *station = NULL);
+    uint8_t scanBand(kt09xx_station *stations, uint8_t maxStations);
+    void sweep(uint16_t lowChannel, uint16_t step, uint16_t count, uint8_t *rssi, uint8_t *snr = NULL);
+    uint16_t sweepBand(uint8_t *rssi, uint8_t *snr, uint16_t maxSamples);
+
+    void getStationEntry(uint8_t band, kt09xx_station_entry &entry);
+    void applyStation(const kt09xx_band_image &bandImage, const kt09xx_station_entry &entry);
 
     void enableDialMode();
     void enableINT();
@@ -2211,7 +2892,10 @@ public:
     void setAMIFBW(uint8_t mwIFBW);
     
     
+    uint16_t getCurrentChannel();
     uint16_t getCurrentFrequency();
+    uint32_t getCurrentFrequencyKHz();
+    uint32_t getCurrentFrequencyHz();
     uint8_t getAMRSSI();
     uint8_t getAMSNR();
     uint8_t getFMRSSI();
@@ -2219,9 +2903,165 @@ public:
     uint8_t getRSSI();
     uint8_t getSNR();
     void setIntMode(bool isRising);
+    void readStatus(kt09xx_signal_status &status);
+
+    bool queueRegister(int reg, uint8_t value, uint8_t mask = 0xFF);
+    bool queueCallback(kt09xx_command_callback callback, uint8_t tag);
+    bool queueVolume(int8_t volume, kt09xx_command_callback callback = NULL, uint8_t tag = 0);
+    bool queueBand(const kt09xx_band_image &image, kt09xx_command_callback callback = NULL, uint8_t tag = 0);
+    uint8_t getQueueFree();
+    bool poll();
+
+    void onChannelChanged(kt09xx_channel_callback callback);
+    void onTuneInterrupt();
+    bool serviceTuneEvents();
+    uint8_t getTuneEventOverflow();
+
+    void onTelemetry(kt09xx_telemetry_callback callback);
+    void setTelemetryRate(uint16_t fastMs, uint16_t slowMs);
+    void setTelemetryHysteresis(uint8_t rssi, uint8_t snr);
+    uint16_t getTelemetryInterval();
+    bool pollTelemetry();
+
+    uint8_t getFilteredRSSI();
+    uint8_t getFilteredSNR();
+    uint8_t getMedianRSSI();
+    uint8_t getMedianSNR();
+    bool getSignalStats(uint8_t mode, uint8_t metric, kt09xx_signal_stats &stats);
+    void clearSignalHistory();
+
+    void setRSSIBias(uint8_t calibrationBand, int8_t bias);
+    int8_t getRSSIBias(uint8_t calibrationBand);
+    int16_t getRSSILevel(uint8_t unit = RSSI_UNIT_DBUVEMF);
+    static int16_t convertRSSI(uint8_t rssi, uint8_t unit);
+    bool calibrateRSSI(int16_t referenceLevel, uint8_t unit = RSSI_UNIT_DBUVEMF, uint8_t samples = CALIBRATION_SAMPLES);
+
+#if KT0937_TRACE
+    void clearTrace();
+    uint8_t getTraceCount();
+    kt09xx_trace_entry getTraceEntry(uint8_t i);
+    uint16_t getRegisterReads(int reg);
+    uint16_t getRegisterWrites(int reg);
+    void dumpTrace(Print &out);
+    void dumpRegisterHistogram(Print &out, uint8_t top);
+#endif
     
 
 
+};
+
+/**
+ * @ingroup GA01
+ * @brief Radio service: runs the commands posted by any task, core or ISR, by priority
+ * @details Commands are posted into a bounded ring buffer of KT0937_SERVICE_QUEUE_SIZE entries and never wait 
+ * @details for the bus. A newer command replaces a waiting one of the same type (ten volume changes, one write). 
+ * @details The service moves them into one pending slot per type and runs the pending slots in SERVICE_* order. 
+ * @details With KT0937_LOCK_FREERTOS, begin() starts a task that owns the radio; otherwise call poll() from loop().
+ */
+class KT0937Service
+{
+protected:
+    KT0937 *radio;
+    kt09xx_service_command pending[SERVICE_COMMAND_COUNT];  //!< newest command of each type
+    uint8_t pendingMask = 0;                                //!< bit n = pending[n] waits to run
+    uint16_t coalescedCount = 0;                            //!< commands replaced before they ran
+    volatile uint16_t overflowCount = 0;                    //!< commands lost because the queue was full
+    kt09xx_status_callback statusCallback = NULL;
+    kt09xx_command_callback completedCallback = NULL;
+
+    kt09xx_service_command ring[KT0937_SERVICE_QUEUE_SIZE]; //!< posted commands
+    volatile uint8_t ringHead = 0;                          //!< next free entry
+    volatile uint8_t ringTail = 0;                          //!< next entry to pick up
+    volatile uint8_t ringCount = 0;                         //!< entries waiting
+    volatile uint16_t ringCoalescedCount = 0;               //!< commands replaced in the ring buffer (see pushRing)
+#if KT0937_LOCK == KT0937_LOCK_FREERTOS
+#if defined(ESP32)
+    portMUX_TYPE ringMux = portMUX_INITIALIZER_UNLOCKED;    //!< ring buffer lock, shared by both cores
+#endif
+    TaskHandle_t task = NULL;
+
+    static void taskMain(void *arg);
+#elif KT0937_LOCK == KT0937_LOCK_STD
+    std::mutex ringMutex;
+#endif
+
+    bool pushRing(const kt09xx_service_command &command);
+
+    bool receive(kt09xx_service_command &command);
+    void coalesce(const kt09xx_service_command &command);
+    bool runNext();
+    void run(const kt09xx_service_command &command);
+
+public:
+    KT0937Service(KT0937 &radio);
+#if KT0937_LOCK == KT0937_LOCK_FREERTOS
+    bool begin(UBaseType_t priority = 2, int8_t core = -1, uint32_t stackSize = KT0937_SERVICE_STACK);
+#endif
+    bool post(const kt09xx_service_command &command);
+    bool postFromISR(const kt09xx_service_command &command);
+    bool setMute(bool mute);
+    bool setVolume(int8_t volume);
+    bool setChannel(uint16_t channel);
+    bool setBand(const kt09xx_band_image &image);
+    bool requestStatus();
+    void onStatus(kt09xx_status_callback callback);
+    void onCompleted(kt09xx_command_callback callback);
+    bool poll();
+    uint16_t getCoalescedCount();
+    uint16_t getOverflowCount();
+};
+
+/**
+ * @ingroup GA01
+ * @brief Byte storage used by KT0937StationStore (EEPROM, NVS, flash, a file on a host...)
+ * @details Erased bytes read 0xFF. write() is only called on erased bytes.
+ */
+class KT0937Storage
+{
+public:
+    virtual ~KT0937Storage() {}
+    virtual uint16_t size() = 0;                                            //!< storage size in bytes
+    virtual bool read(uint16_t address, uint8_t *buf, uint16_t n) = 0;
+    virtual bool write(uint16_t address, const uint8_t *buf, uint16_t n) = 0;
+    virtual bool erase(uint16_t address, uint16_t n) = 0;                   //!< sets n bytes to 0xFF
+};
+
+/**
+ * @ingroup GA01
+ * @brief Station memory: presets and a wear levelled log of the last station
+ * @details Layout from base: presetCount preset slots, then the log, split into two halves written in turn. 
+ * @details Every saveStation appends one entry; a half is erased only once the newest entry is in the other 
+ * @details one, so each byte is written once per round and a power loss never leaves the log without the 
+ * @details last station. The last station is the entry before the first erased slot of the newest half.
+ */
+class KT0937StationStore
+{
+protected:
+    KT0937Storage *storage;
+    uint16_t base;                      //!< first byte used
+    uint16_t size;                      //!< bytes used from base (0 = up to the end of the storage)
+    uint8_t presetCount;                //!< preset slots before the log
+    uint16_t logStart;                  //!< first byte of the log
+    uint16_t logSlots = 0;              //!< log size in entries (two halves of logSlots / 2). Set by begin
+    uint16_t logLast = STATION_LOG_EMPTY;   //!< slot of the last station (STATION_LOG_EMPTY = none)
+
+    bool readEntry(uint16_t address, kt09xx_station_entry &entry);
+    bool writeEntry(uint16_t address, const kt09xx_station_entry &entry);
+    bool isSlotErased(uint16_t slot, bool &erased);
+    bool findHalfEnd(uint16_t first, uint16_t &count);
+    bool eraseHalf(uint16_t first);
+
+public:
+    KT0937StationStore(KT0937Storage &storage, uint8_t presetCount = 0, uint16_t base = 0, uint16_t size = 0);
+    bool begin();
+    bool saveStation(const kt09xx_station_entry &entry);
+    bool loadStation(kt09xx_station_entry &entry);
+    bool savePreset(uint8_t index, const kt09xx_station_entry &entry);
+    bool loadPreset(uint8_t index, kt09xx_station_entry &entry);
+    bool clear();
+
+    static void packEntry(const kt09xx_station_entry &entry, uint8_t *buf);
+    static bool unpackEntry(const uint8_t *buf, kt09xx_station_entry &entry);
 };
 
 #endif